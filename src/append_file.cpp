@@ -0,0 +1,71 @@
+#include "append_file.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+AppendFile::AppendFile() : fd(-1) {}
+
+AppendFile::~AppendFile()
+{
+    close();
+}
+
+bool AppendFile::open(const string &filename)
+{
+    close();
+#ifdef _WIN32
+    fd = _open(filename.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+#endif
+    return fd >= 0;
+}
+
+void AppendFile::close()
+{
+    if (fd < 0)
+        return;
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    fd = -1;
+}
+
+bool AppendFile::isOpen() const { return fd >= 0; }
+
+bool AppendFile::append(string_view data)
+{
+    while (fd >= 0 && !data.empty())
+    {
+#ifdef _WIN32
+        int written = _write(fd, data.data(), (unsigned)data.size());
+#else
+        ssize_t written = ::write(fd, data.data(), data.size());
+#endif
+        if (written <= 0)
+            return false;
+        data.remove_prefix((size_t)written);
+    }
+    return fd >= 0;
+}
+
+bool AppendFile::sync()
+{
+    if (fd < 0)
+        return false;
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef APPEND_FILE_HPP
+#define APPEND_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Write-only file opened in append mode, with an explicit durable sync.
+// Appends go straight to the OS (no user-space buffer), so a crash of the
+// game loses nothing already appended; sync() also survives power loss.
+class AppendFile
+{
+private:
+    int fd;
+
+public:
+    AppendFile();
+    ~AppendFile();
+
+    AppendFile(const AppendFile &) = delete;
+    AppendFile &operator=(const AppendFile &) = delete;
+
+    bool open(const string &filename); // creates the file if needed
+    void close();
+    bool isOpen() const;
+
+    bool append(string_view data);
+    bool sync(); // fsync / _commit
+};
+
+#endif
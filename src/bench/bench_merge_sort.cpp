@@ -0,0 +1,97 @@
+#include "leaderboard.hpp"
+#include "merge_sort.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+// Leaderboard sort timings: the recursive merge sort the leaderboard used to
+// load with, MergeSorter at 1..N threads, and std::stable_sort for scale.
+//   wwtbam-bench-sort [entries] (default 2000000)
+
+// The previous Leaderboard::mergeSort/merge, kept here as the baseline. It
+// takes the right element on ties, so it is not stable.
+static void recursiveMerge(vector<LeaderboardEntry> &arr, int left, int mid, int right)
+{
+    vector<LeaderboardEntry> temp;
+    int i = left, j = mid + 1;
+
+    while (i <= mid && j <= right)
+    {
+        if (arr[i] < arr[j])
+            temp.push_back(arr[i++]);
+        else
+            temp.push_back(arr[j++]);
+    }
+    while (i <= mid)
+        temp.push_back(arr[i++]);
+    while (j <= right)
+        temp.push_back(arr[j++]);
+
+    for (int i = left, k = 0; i <= right; i++, k++)
+        arr[i] = temp[k];
+}
+
+static void recursiveMergeSort(vector<LeaderboardEntry> &arr, int left, int right)
+{
+    if (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        recursiveMergeSort(arr, left, mid);
+        recursiveMergeSort(arr, mid + 1, right);
+        recursiveMerge(arr, left, mid, right);
+    }
+}
+
+static vector<LeaderboardEntry> makeGames(size_t count)
+{
+    mt19937 rng(42);
+    vector<LeaderboardEntry> games(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        int level = (int)(rng() % 16);
+        games[i] = {"player" + to_string(rng() % 100000), (long long)(rng() % 1000000), level, level, (long long)i};
+    }
+    return games;
+}
+
+template <typename Sort>
+static void timeSort(const string &label, const vector<LeaderboardEntry> &games, const vector<LeaderboardEntry> &expected,
+                     bool stable, Sort sort)
+{
+    vector<LeaderboardEntry> items = games;
+    auto start = chrono::steady_clock::now();
+    sort(items);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Same ranking as stable_sort; stable sorts must also keep tied games
+    // in their original order
+    bool same = items.size() == expected.size();
+    for (size_t i = 0; same && i < items.size(); i++)
+        same = stable ? items[i].timestamp == expected[i].timestamp : !(items[i] < expected[i]) && !(expected[i] < items[i]);
+    cout << left << setw(24) << label << right << fixed << setprecision(1) << setw(10) << elapsed * 1000 << " ms"
+         << (same ? "" : "  MISMATCH") << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? (size_t)max(1L, atol(argv[1])) : 2000000;
+    vector<LeaderboardEntry> games = makeGames(count);
+    vector<LeaderboardEntry> expected = games;
+    stable_sort(expected.begin(), expected.end());
+    cout << count << " entries\n\n";
+
+    timeSort("recursive mergeSort", games, expected, false, [](vector<LeaderboardEntry> &items)
+             { recursiveMergeSort(items, 0, (int)items.size() - 1); });
+    timeSort("std::stable_sort", games, expected, true, [](vector<LeaderboardEntry> &items)
+             { stable_sort(items.begin(), items.end()); });
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+        timeSort("MergeSorter x" + to_string(threads), games, expected, true, [threads](vector<LeaderboardEntry> &items)
+                 { MergeSorter<LeaderboardEntry>::sort(items, threads); });
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "question_bank.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cstdio>
+
+using namespace std;
+
+// Question bank timings: load per mode and thread count and per-game
+// question selection on one bank, then findRecord lookups on dense and
+// sparse IDs across bank sizes, which should stay flat as the bank grows.
+// Runs on generated banks so results can be compared between machines:
+//   wwtbam-bench-bank [questions] [largest lookup bank]
+// (defaults 1000000 and 10000000)
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Same line format as docs/questions.txt; stride > 1 spreads the IDs out
+static bool generateBank(const string &filename, int count, int stride)
+{
+    ofstream file(filename, ios::trunc);
+    mt19937 rng(42);
+    for (int i = 1; i <= count; i++)
+    {
+        int category = 1 + (int)(rng() % 8);
+        int difficulty = 1 + (int)(rng() % 3);
+        file << (long long)i * stride << "|" << category << "|Benchmark question number " << i
+             << " about category " << category << "?|First answer " << i << "|Second answer|Third answer|Fourth answer|"
+             << rng() % 4 << "|A hint for question " << i << "|" << difficulty << "\n";
+    }
+    file.close();
+    return !file.fail();
+}
+
+static void timeLoad(const string &label, const string &filename, LoadMode mode, unsigned threads)
+{
+    auto start = chrono::steady_clock::now();
+    QuestionBank bank;
+    if (!bank.loadFromFile(filename, mode, threads))
+    {
+        cout << left << setw(24) << label << "failed\n";
+        return;
+    }
+    cout << left << setw(24) << label << right << fixed << setprecision(1) << setw(10) << secondsSince(start) * 1000 << " ms\n";
+}
+
+static const int LOOKUPS = 10000000;
+
+// Nanoseconds per lookup over a working set of that many random IDs
+static double lookupCost(const QuestionBank &bank, int count, int stride, size_t workingSet, long long &found)
+{
+    vector<int> ids(workingSet);
+    mt19937 rng(7);
+    for (int &id : ids)
+        id = (int)(1 + rng() % count) * stride;
+
+    auto start = chrono::steady_clock::now();
+    found = 0;
+    for (int i = 0; i < LOOKUPS; i++)
+        found += bank.findRecord(ids[i & (ids.size() - 1)]) >= 0;
+    return secondsSince(start) * 1e9 / LOOKUPS;
+}
+
+// One row per bank size and ID layout. Hot IDs stay in cache, so that
+// column is the index's own cost; spread IDs cover the whole bank and add
+// the cache misses a large bank pays.
+static void timeLookups(const QuestionBank &bank, int count, const string &layout, int stride)
+{
+    long long hotFound, spreadFound;
+    double hot = lookupCost(bank, count, stride, 1 << 10, hotFound);
+    double spread = lookupCost(bank, count, stride, 1 << 20, spreadFound);
+    cout << right << setw(12) << count << "  " << left << setw(8) << layout << right << fixed << setprecision(1)
+         << setw(10) << hot << setw(12) << spread << (hotFound == LOOKUPS && spreadFound == LOOKUPS ? "" : "  (misses)")
+         << "\n";
+}
+
+static void timeSelection(const QuestionBank &bank)
+{
+    const int GAMES = 20000;
+    const int QUESTIONS_PER_GAME = 15;
+    auto start = chrono::steady_clock::now();
+    long long served = 0;
+    for (int game = 0; game < GAMES; game++)
+    {
+        SelectionState selection;
+        bank.startSession(selection, (uint64_t)game * 0x9E3779B97F4A7C15ull);
+        for (int level = 0; level < QUESTIONS_PER_GAME; level++)
+        {
+            int difficulty = level < 5 ? 1 : level < 10 ? 2 : 3;
+            served += bank.selectQuestion(selection, difficulty, "classic").id != -1;
+        }
+    }
+    double elapsed = secondsSince(start);
+    cout << left << setw(24) << "select (per game)" << right << fixed << setprecision(2) << setw(10)
+         << elapsed * 1e6 / GAMES << " us (" << served << " questions)\n";
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? max(1, atoi(argv[1])) : 1000000;
+    int largest = argc > 2 ? max(1, atoi(argv[2])) : 10000000;
+    const string denseFile = "bench_questions.txt";
+    const string sparseFile = "bench_questions_sparse.txt";
+    const string packFile = "bench_questions.qpack";
+    const int SPARSE_STRIDE = 97; // past the dense table's reach, and 10M banks still fit an int
+
+    if (!generateBank(denseFile, count, 1))
+    {
+        cerr << "Could not write the generated bank\n";
+        return 1;
+    }
+    cout << count << " questions\n\n";
+
+    timeLoad("load STREAM", denseFile, LoadMode::STREAM, 0);
+    timeLoad("load MAPPED", denseFile, LoadMode::MAPPED, 0);
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2)
+        timeLoad("load PARALLEL x" + to_string(threads), denseFile, LoadMode::PARALLEL, threads);
+    timeLoad("load PAGED", denseFile, LoadMode::PAGED, 0);
+    {
+        QuestionBank bank;
+        if (bank.loadFromFile(denseFile) && bank.saveToPack(packFile))
+            timeLoad("load PACK", packFile, LoadMode::PACK, 0);
+    }
+    cout << "\n";
+
+    {
+        QuestionBank bank;
+        if (!bank.loadFromFile(denseFile))
+            return 1;
+        timeSelection(bank);
+    }
+    remove(packFile.c_str());
+
+    // PAGED keeps only the index resident, so the largest banks fit in memory
+    cout << "\nfindRecord ns/lookup by bank size\n";
+    cout << right << setw(12) << "questions" << "  " << left << setw(8) << "IDs" << right << setw(10) << "hot" << setw(12)
+         << "spread" << "\n";
+    for (int size : {300, 10000, 1000000, 10000000})
+    {
+        if (size > largest)
+            break;
+        for (int stride : {1, SPARSE_STRIDE})
+        {
+            const string &file = stride == 1 ? denseFile : sparseFile;
+            QuestionBank bank;
+            if (!generateBank(file, size, stride) || !bank.loadFromFile(file, LoadMode::PAGED))
+            {
+                cerr << "Could not generate a bank of " << size << " questions\n";
+                break;
+            }
+            timeLookups(bank, size, stride == 1 ? "dense" : "sparse", stride);
+        }
+    }
+
+    remove(denseFile.c_str());
+    remove(sparseFile.c_str());
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "session_manager.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <random>
+
+using namespace std;
+
+// Sessions per core: each thread keeps LIVE games open and plays them round
+// robin until time runs out, opening a new game whenever one ends, so
+// requests spread over many sessions the way a classroom's do. Reports
+// requests per second per core and how many players one core keeps up with
+// at one request every THINK_SECONDS, then the memory an idle session holds.
+// Runs in a scratch docs directory with a generated bank:
+//   wwtbam-bench-sessions [seconds per thread count] (default 2)
+
+static const int LIVE = 500;           // open sessions per thread
+static const int THINK_SECONDS = 10;   // a player's pace: one request per this
+static const int IDLE_SESSIONS = 50000;
+static const int QUESTIONS = 20000;
+
+static bool generateBank(const string &filename)
+{
+    ofstream file(filename, ios::trunc);
+    mt19937 rng(42);
+    for (int i = 1; i <= QUESTIONS; i++)
+    {
+        int category = 1 + (int)(rng() % 8);
+        int difficulty = 1 + (int)(rng() % 3);
+        file << i << "|" << category << "|Benchmark question number " << i << "?|First answer " << i
+             << "|Second answer|Third answer|Fourth answer|" << rng() % 4 << "|A hint for question " << i << "|"
+             << difficulty << "\n";
+    }
+    file.close();
+    return !file.fail();
+}
+
+// Resident memory in bytes, 0 where it can't be read
+static size_t residentBytes()
+{
+#ifdef __linux__
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * 4096;
+#else
+    return 0;
+#endif
+}
+
+struct Tally
+{
+    long long requests = 0;
+    long long games = 0;
+};
+
+static void play(SessionManager &manager, int thread, chrono::steady_clock::time_point deadline, Tally &tally)
+{
+    mt19937 rng(thread + 1);
+    int started = 0;
+    auto startGame = [&]
+    { return manager.startSession("t" + to_string(thread) + "p" + to_string(started++), "M"); };
+
+    vector<uint64_t> live(LIVE);
+    for (uint64_t &id : live)
+        id = startGame();
+    while (chrono::steady_clock::now() < deadline)
+    {
+        for (uint64_t &id : live)
+        {
+            // Mostly right, so games run to a realistic length
+            Question question;
+            bool asked = manager.nextQuestion(id, question);
+            tally.requests++;
+            if (asked)
+            {
+                int correct = question.displayedCorrectIndex();
+                AnswerOutcome outcome = manager.answer(id, rng() % 10 < 9 ? correct : (correct + 1) % 4);
+                tally.requests++;
+                if (outcome == AnswerOutcome::CORRECT)
+                    continue;
+            }
+            manager.endSession(id);
+            tally.games++;
+            id = startGame();
+        }
+    }
+    for (uint64_t id : live)
+        manager.endSession(id);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? max(0.1, atof(argv[1])) : 2.0;
+
+    // The manager works in docs/ under the current directory
+    filesystem::path scratch = filesystem::temp_directory_path() / "wwtbam_bench_sessions";
+    error_code ec;
+    filesystem::remove_all(scratch, ec);
+    filesystem::create_directories(scratch / "docs");
+    filesystem::current_path(scratch);
+    if (!generateBank("docs/questions.txt"))
+    {
+        cerr << "Could not write the generated bank\n";
+        return 1;
+    }
+
+    {
+        SessionManager manager;
+        if (!manager.initialize("docs/questions.txt"))
+            return 1;
+
+        // Games end far faster here than in a hall, so the persistence queue
+        // fills and saves run on the playing threads. That cost is measured;
+        // its warnings are not printed.
+        streambuf *errors = cerr.rdbuf(nullptr);
+        cout << LIVE << " open sessions per thread, " << seconds << " s per run\n\n";
+        cout << left << setw(10) << "threads" << right << setw(14) << "requests/s" << setw(14) << "per core"
+             << setw(12) << "games/s" << setw(22) << "players per core" << "\n";
+
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        for (unsigned threads = 1; threads <= cores; threads *= 2)
+        {
+            vector<Tally> tallies(threads);
+            vector<thread> workers;
+            auto start = chrono::steady_clock::now();
+            auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+            for (unsigned t = 0; t < threads; t++)
+                workers.emplace_back(play, ref(manager), (int)t, deadline, ref(tallies[t]));
+            for (thread &worker : workers)
+                worker.join();
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            Tally total;
+            for (const Tally &tally : tallies)
+            {
+                total.requests += tally.requests;
+                total.games += tally.games;
+            }
+            double perCore = total.requests / elapsed / threads;
+            cout << left << setw(10) << threads << right << fixed << setprecision(0) << setw(14)
+                 << total.requests / elapsed << setw(14) << perCore << setw(12) << total.games / elapsed << setw(22)
+                 << perCore * THINK_SECONDS << "\n";
+        }
+
+        // Sessions opened and left waiting, as a full hall between questions
+        size_t before = residentBytes();
+        vector<uint64_t> idle;
+        idle.reserve(IDLE_SESSIONS);
+        for (int i = 0; i < IDLE_SESSIONS; i++)
+            idle.push_back(manager.startSession("idle" + to_string(i), "F"));
+        size_t after = residentBytes();
+        if (before > 0)
+            cout << "\n" << IDLE_SESSIONS << " idle sessions: " << (after - before) / IDLE_SESSIONS << " bytes each\n";
+        for (uint64_t id : idle)
+            manager.endSession(id);
+        manager.shutdown();
+        cerr.rdbuf(errors);
+        cerr.clear();
+    }
+
+    filesystem::current_path(scratch.parent_path());
+    filesystem::remove_all(scratch, ec);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Bounded multi-producer multi-consumer lock-free queue (Vyukov). Each cell
+// carries a sequence number that says whose turn it is, so producers and
+// consumers only contend on their own position counter. Never blocks:
+// tryPush fails when full and tryPop when empty.
+template <typename T>
+class BoundedQueue
+{
+private:
+    struct Cell
+    {
+        atomic<size_t> sequence;
+        T data;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos;
+    alignas(64) atomic<size_t> dequeuePos;
+
+public:
+    explicit BoundedQueue(size_t capacity) // rounded up to a power of two
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+            cells[i].sequence.store(i, memory_order_relaxed);
+        enqueuePos.store(0, memory_order_relaxed);
+        dequeuePos.store(0, memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    bool tryPush(T &&value)
+    {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+            if (difference == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    cell.data = move(value);
+                    cell.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false; // full
+            else
+                pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+
+    bool tryPop(T &value)
+    {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (difference == 0)
+            {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                {
+                    value = move(cell.data);
+                    cell.sequence.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false; // empty
+            else
+                pos = dequeuePos.load(memory_order_relaxed);
+        }
+    }
+};
+
+#endif
@@ -1,5 +1,32 @@
 #include "data_structures.hpp"
 
+const unsigned char OPTION_PERMUTATIONS[24][4] = {
+    {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {0, 3, 2, 1},
+    {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0}, {1, 3, 0, 2}, {1, 3, 2, 0},
+    {2, 0, 1, 3}, {2, 0, 3, 1}, {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 3, 0, 1}, {2, 3, 1, 0},
+    {3, 0, 1, 2}, {3, 0, 2, 1}, {3, 1, 0, 2}, {3, 1, 2, 0}, {3, 2, 0, 1}, {3, 2, 1, 0}};
+
+int displayedOptionIndex(unsigned char optionOrder, int storedIndex)
+{
+    const unsigned char *order = OPTION_PERMUTATIONS[optionOrder % 24];
+    for (int slot = 0; slot < 4; slot++)
+    {
+        if (order[slot] == storedIndex)
+            return slot;
+    }
+    return -1;
+}
+
+const char *Question::displayedOption(int slot) const
+{
+    return options[OPTION_PERMUTATIONS[optionOrder % 24][slot]];
+}
+
+int Question::displayedCorrectIndex() const
+{
+    return displayedOptionIndex(optionOrder, correctAnswerIndex);
+}
+
 
 PrizeLadder::PrizeLadder() : head(nullptr), current(nullptr), totalLevels(0)
 {
@@ -106,14 +133,15 @@ Player::Player() : totalWinnings(0), questionsAnswered(0), currentLevel(0)
     lifelinesUsed[3] = 0;
 }
 
-void Player::recordQuestion(int qID)
+void Player::recordQuestion(int recordIndex)
 {
-    questionsAsked[qID] = true;
+    if (recordIndex >= 0)
+        questionsAsked.insert((uint32_t)recordIndex);
 }
 
-bool Player::hasAskedQuestion(int qID) const
+bool Player::hasAskedQuestion(int recordIndex) const
 {
-    return questionsAsked.find(qID) != questionsAsked.end();
+    return recordIndex >= 0 && questionsAsked.contains((uint32_t)recordIndex);
 }
 
 // LifelineStack Implementation
@@ -7,16 +7,33 @@
 #include <queue>
 #include <stack>
 #include <iostream>
+#include <memory>
+#include "question_set.hpp"
 
 using namespace std;
 
+// All 4! orderings of four options. A permutation code (0-23) picks one;
+// row[slot] is the stored option shown in display slot A-D.
+extern const unsigned char OPTION_PERMUTATIONS[24][4];
+int displayedOptionIndex(unsigned char optionOrder, int storedIndex);
+
+// View of one question. The strings live in the question bank (or a page
+// pinned by the view for paged banks), so copying a Question never allocates.
+// Options stay in stored order; optionOrder says how this session shows them.
+// A default Question is "no question".
 struct Question {
-    int id;
-    int category;
-    string text;
-    vector<string> options;
-    int correctAnswerIndex;
-    string hint;
+    int id = -1;
+    int category = 0;
+    int recordIndex = -1; // in the bank it was served from
+    const char* text = "";
+    const char* options[4] = {"", "", "", ""}; // stored order
+    int correctAnswerIndex = -1;               // into options, stored order
+    const char* hint = "";
+    unsigned char optionOrder = 0;             // per-session permutation code
+    shared_ptr<const vector<char>> page;       // paged banks only
+
+    const char* displayedOption(int slot) const; // slot 0-3 = A-D
+    int displayedCorrectIndex() const;           // -1 for no question
 };
 
 
@@ -60,12 +77,12 @@ struct Player {
     long long totalWinnings;
     int questionsAnswered;
     int currentLevel;
-    unordered_map<int, bool> questionsAsked;
+    QuestionSet questionsAsked; // record indexes in this game's question bank
     int lifelinesUsed[4]; // 0: 50-50, 1: Ask Friend, 2: Skip, 3: Hint
 
     Player();
-    void recordQuestion(int qID);
-    bool hasAskedQuestion(int qID) const;
+    void recordQuestion(int recordIndex);
+    bool hasAskedQuestion(int recordIndex) const;
 };
 
 
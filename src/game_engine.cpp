@@ -1,4 +1,5 @@
 #include "game_engine.hpp"
+#include <random>
 
 using namespace std;
 
@@ -26,14 +27,38 @@ string QuoteManager::getRandomQuote() const
 
 // --- GameEngine Implementation ---
 
-GameEngine::GameEngine() : timeLimit(30), gameActive(false), correctAnswerStreak(0),
-                           totalPointsEarned(0), currentCategoryId(-1)
+GameEngine::GameEngine() : gameMode("classic"), replicator(leaderboard), timeLimit(30), gameActive(false), correctAnswerStreak(0),
+                           totalPointsEarned(0), currentCategoryId(-1), sessionSeed(0), finalRank(0), rankedGames(0),
+                           persistence(leaderboard, playerProfileManager, replicator)
 {
 }
 
-bool GameEngine::initialize(const string &questionsFile)
+bool GameEngine::initialize(const string &questionsFile, size_t pageCacheBytes)
 {
-    return questionBank.loadFromFile(questionsFile);
+    // Used for the first load and again for every hot reload of the file
+    auto loadBank = [pageCacheBytes](QuestionBank &bank, const string &filename)
+    {
+        // The watcher follows the text file; a compiled pack beside it is
+        // used only while it is at least as new, so edits reload from text
+        string pack = pageCacheBytes > 0 ? "" : QuestionBank::currentPackFor(filename);
+        if (pack.empty() || !bank.loadFromFile(pack))
+        {
+            LoadMode mode = pageCacheBytes > 0 ? LoadMode::PAGED : LoadMode::PARALLEL;
+            if (!bank.loadFromFile(filename, mode))
+                return false;
+        }
+        if (pageCacheBytes > 0)
+            bank.setPageCacheBudget(pageCacheBytes);
+
+        // Optional per-mode category weights
+        bank.loadCategoryMixes("docs/game_modes.txt");
+        return true;
+    };
+
+    if (!bankWatcher.start(questionsFile, loadBank))
+        return false;
+    questionBank = bankWatcher.current();
+    return true;
 }
 
 void GameEngine::setupPlayer(const string &name, const string &gender)
@@ -48,17 +73,59 @@ void GameEngine::setupPlayer(const string &name, const string &gender)
     player.totalWinnings = 0;
     player.currentLevel = 0;
     player.questionsAnswered = 0;
+    player.questionsAsked.clear();
+    answerLog.clear();
+
+    // A game keeps the bank it started with even if the file is reloaded
+    // mid-game; every game walks its own permutation of each bucket. The
+    // previous question points into the old bank, so drop it first.
+    currentQuestion = Question();
+    questionBank = bankWatcher.current();
+    random_device device;
+    sessionSeed = ((uint64_t)device() << 32) ^ (uint64_t)time(0);
+
+    // A returning player's history is already in memory, including their
+    // last game; anyone else's file is read while they look at the rules
+    if (seenLoad.valid())
+        seenLoad.get();
+    if (seenHistory.getProfileName() == name)
+        questionBank->startSession(selection, sessionSeed, &seenHistory.getSeen());
+    else
+        seenLoad = async(launch::async, [this, name]
+                         { return seenHistory.load(name); });
+}
+
+void GameEngine::awaitSeenHistory()
+{
+    // Blocks only if the first question comes before the file was read
+    if (!seenLoad.valid())
+        return;
+    seenLoad.get();
+    questionBank->startSession(selection, sessionSeed, &seenHistory.getSeen());
+}
+
+void GameEngine::setGameMode(const string &mode)
+{
+    // Modes without a mix in docs/game_modes.txt draw like classic
+    shared_ptr<const QuestionBank> bank = bankWatcher.current();
+    if (bank && mode != "classic" && !bank->hasCategoryMix(mode))
+        cerr << "Warning: no category mix for game mode '" << mode << "', drawing from the whole bank" << endl;
+    gameMode = mode;
 }
 
+const string &GameEngine::getGameMode() const { return gameMode; }
+
 bool GameEngine::getNextQuestion()
 {
-    currentQuestion = questionBank.getNextQuestion(player);
+    awaitSeenHistory();
+    int difficulty = gameLogic.getNextDifficulty(player.currentLevel);
+    currentQuestion = questionBank->selectQuestion(selection, difficulty, gameMode);
     if (currentQuestion.id == -1)
         return false;
-    player.recordQuestion(currentQuestion.id);
+    player.recordQuestion(currentQuestion.recordIndex);
+    seenHistory.record(currentQuestion.id);
 
     currentCategoryId = currentQuestion.category;
-    int difficulty = gameLogic.getNextDifficulty(player.currentLevel);
     timeLimit = gameLogic.getTimeLimit(difficulty);
     gameTimer.setDuration(timeLimit);
     gameTimer.start();
@@ -68,7 +135,8 @@ bool GameEngine::getNextQuestion()
 
 bool GameEngine::processAnswer(int optionIndex)
 {
-    bool isCorrect = questionBank.isCorrectAnswer(currentQuestion.id, optionIndex);
+    bool isCorrect = questionBank->isCorrectAnswer(currentQuestion.id, optionIndex, currentQuestion.optionOrder);
+    answerLog.push_back({currentQuestion.category, isCorrect});
 
     if (isCorrect)
     {
@@ -145,14 +213,35 @@ void GameEngine::endGame()
 {
     gameActive = false;
     gameTimer.stop();
+    awaitSeenHistory();
 
-    playerProfileManager.updatePlayerStats(
-        player.name,
-        player.totalWinnings,
-        player.currentLevel,
-        player.questionsAnswered);
+    // Ranked against the board now; the worker adds the entry itself shortly
+    long long now = (long long)time(nullptr);
+    LeaderboardEntry entry = {player.name, player.totalWinnings, player.currentLevel, player.questionsAnswered, now};
+    finalRank = leaderboard.getRank(entry);
+    rankedGames = leaderboard.getTotalGames() + 1;
 
-    leaderboard.addEntry(player, "");
+    // Profile and leaderboard are updated and saved by the persistence worker
+    persistence.submit({player.name,
+                        player.totalWinnings,
+                        player.currentLevel,
+                        player.questionsAnswered,
+                        now,
+                        move(answerLog),
+                        seenHistory.pathFor(player.name),
+                        seenHistory.takeRecorded()});
+    answerLog.clear();
+}
+
+void GameEngine::shutdown()
+{
+    persistence.flush();
+    replicator.stop();
+}
+
+bool GameEngine::startReplication(int port, const vector<string> &peers)
+{
+    return replicator.start(port, peers);
 }
 
 string GameEngine::getRandomQuote() const
@@ -166,6 +255,8 @@ const Question &GameEngine::getCurrentQuestion() const { return currentQuestion;
 Leaderboard &GameEngine::getLeaderboard() { return leaderboard; }
 int GameEngine::getTotalPoints() const { return totalPointsEarned; }
 int GameEngine::getCorrectStreak() const { return correctAnswerStreak; }
+int GameEngine::getFinalRank() const { return finalRank; }
+int GameEngine::getRankedGames() const { return rankedGames; }
 
 PlayerStats GameEngine::getPlayerProfile()
 {
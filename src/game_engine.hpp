@@ -3,13 +3,17 @@
 
 #include "data_structures.hpp"
 #include "question_bank.hpp"
+#include "question_bank_watcher.hpp"
 #include "leaderboard.hpp"
 #include "game_logic.hpp"
 #include "timer.hpp"
 #include "player_profile.hpp"
+#include "seen_history.hpp"
+#include "persistence_worker.hpp"
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <future>
 #include <vector>
 
 using namespace std;
@@ -28,10 +32,14 @@ class GameEngine
 {
 private:
     Player player;
-    QuestionBank questionBank;
+    QuestionBankWatcher bankWatcher;             // reloads the bank file when it changes
+    shared_ptr<const QuestionBank> questionBank; // snapshot this game started with
+    SelectionState selection; // this game's question order per (category, difficulty)
+    string gameMode;
     PrizeLadder prizeLadder;
     LifelineStack lifelineStack;
     Leaderboard leaderboard;
+    LeaderboardReplicator replicator; // shares the leaderboard with other instances once started
     GameLogic gameLogic;
     GameTimer gameTimer;
     QuoteManager quoteManager;
@@ -43,12 +51,23 @@ private:
     int correctAnswerStreak;
     int totalPointsEarned;
     PlayerProfileManager playerProfileManager;
+    SeenHistory seenHistory; // questions this profile was asked in earlier games
+    future<bool> seenLoad;   // reading a new player's history off the frame thread
+    uint64_t sessionSeed;
+    int finalRank;   // placement of the last finished game among all games
+    int rankedGames; // games on the board including it
+    vector<pair<int, bool>> answerLog; // (category, correct) per question this game
+    PersistenceWorker persistence; // writes finished games off the frame loop
+
+    void awaitSeenHistory(); // finishes a pending load and starts this game's selection
 
 public:
     GameEngine();
 
-    bool initialize(const string &questionsFile);
+    bool initialize(const string &questionsFile, size_t pageCacheBytes = 0); // > 0 pages question text from disk
     void setupPlayer(const string &name, const string &gender);
+    void setGameMode(const string &mode);
+    const string &getGameMode() const;
     bool getNextQuestion();
     bool processAnswer(int optionIndex);
     vector<int> use50_50Lifeline();
@@ -57,6 +76,8 @@ public:
     string useHintLifeline();
     bool isLifelineAvailable(int lifelineType) const;
     void endGame();
+    void shutdown(); // writes out everything still queued
+    bool startReplication(int port, const vector<string> &peers); // peers as host:port
 
     // NEW: Expose the quote functionality to the frontend
     string getRandomQuote() const;
@@ -67,6 +88,8 @@ public:
     Leaderboard &getLeaderboard();
     int getTotalPoints() const;
     int getCorrectStreak() const;
+    int getFinalRank() const;
+    int getRankedGames() const;
     PlayerStats getPlayerProfile();
     PlayerProfileManager &getProfileManager();
 
@@ -5,7 +5,10 @@ using namespace std;
 GameLogic::LifelineState::LifelineState() : used(false), usageCount(0) {}
 
 GameLogic::GameLogic() {
-    srand(static_cast<unsigned>(time(0)));
+    // Once per process: sessions create one per game, and reseeding would
+    // replay the same lifeline rolls for games started in the same second
+    static const bool seeded = (srand(static_cast<unsigned>(time(0))), true);
+    (void)seeded;
 }
 
 vector<int> GameLogic::apply50_50Lifeline(const Question& question) {
@@ -13,9 +16,11 @@ vector<int> GameLogic::apply50_50Lifeline(const Question& question) {
         return {};
     }
 
+    // Indices are display slots, in this session's option order
+    int correctSlot = question.displayedCorrectIndex();
     vector<int> wrongIndices;
     for (int i = 0; i < 4; i++) {
-        if (i != question.correctAnswerIndex) {
+        if (i != correctSlot) {
             wrongIndices.push_back(i);
         }
     }
@@ -42,15 +47,16 @@ int GameLogic::applyAskFriendLifeline(const Question& question) {
         return -1;
     }
 
+    int correctSlot = question.displayedCorrectIndex();
     int accuracy = rand() % 100;
     int suggestion;
 
     if (accuracy < 85) {
-        suggestion = question.correctAnswerIndex;
+        suggestion = correctSlot;
     } else {
         do {
             suggestion = rand() % 4;
-        } while (suggestion == question.correctAnswerIndex);
+        } while (suggestion == correctSlot);
     }
 
     lifelineStates[ASK_FRIEND].used = true;
@@ -128,7 +134,7 @@ int GameLogic::getTimeLimit(int difficulty) {
 }
 
 bool GameLogic::validateAnswer(const Question& question, int selectedIndex) const {
-    return selectedIndex == question.correctAnswerIndex;
+    return selectedIndex == question.displayedCorrectIndex();
 }
 
 string GameLogic::getHint(const Question& question) const {
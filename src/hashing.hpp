@@ -0,0 +1,28 @@
+#ifndef HASHING_HPP
+#define HASHING_HPP
+
+#include <cstdint>
+#include <string_view>
+
+// splitmix64 finalizer: cheap, well-mixed 64-bit hash for integer keys
+inline uint64_t mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// FNV-1a: stable 64-bit hash of a string, for file names and on-disk keys
+inline uint64_t fnv1a64(std::string_view text)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#endif
@@ -1,169 +1,872 @@
 #include "leaderboard.hpp"
+#include "leaderboard_segment.hpp"
+#include "leaderboard_history.hpp"
+#include "merge_sort.hpp"
+#include <filesystem>
+#include <ctime>
+#include <climits>
+#include <queue>
 
 using namespace std;
 
+double LeaderboardStats::getWinRate(int category) const
+{
+    auto found = categories.find(category);
+    if (found == categories.end() || found->second.asked == 0)
+        return 0.0;
+    return (double)found->second.correct / (double)found->second.asked;
+}
+
 Leaderboard::Leaderboard()
+    : frozenSeq(0), nextSeq(1), archiving(false), snapshotVersion(0),
+      currentDay(dayOf((long long)time(nullptr))), history(make_unique<LeaderboardHistory>()), categoriesDirty(false)
 {
+    {
+        lock_guard<mutex> lock(entriesMutex);
+        publishSnapshot();
+    }
     loadFromFile();
 }
 
-void Leaderboard::mergeSort(vector<LeaderboardEntry> &arr, int left, int right)
+Leaderboard::~Leaderboard()
+{
+    if (archiver.joinable())
+        archiver.join();
+}
+
+long long Leaderboard::dayOf(long long timestamp)
+{
+    return timestamp / SECONDS_PER_DAY;
+}
+
+void Leaderboard::addEntry(const Player &player, long long timestamp)
+{
+    addEntry({player.name,
+              player.totalWinnings,
+              player.currentLevel,
+              player.questionsAnswered,
+              timestamp});
+    saveToFile();
+}
+
+void Leaderboard::addEntry(const LeaderboardEntry &entry)
+{
+    lock_guard<mutex> lock(entriesMutex);
+    size_t position = entries.insert(entry);
+    unsaved.push_back(entry);
+    countGame(entry);
+    updateMedian();
+    bool windowsChanged = addToDay(entry);
+    bool playersChanged = addToPlayer(entry);
+
+    // Games below every published top only change the stats
+    bool topChanged = position < SNAPSHOT_SIZE && countBeforeAll(entry) < SNAPSHOT_SIZE;
+    if (topChanged || windowsChanged || playersChanged)
+        publishSnapshot();
+    else
+        publishStats();
+}
+
+void Leaderboard::countGame(const LeaderboardEntry &entry)
+{
+    stats.totalGames++;
+    stats.totalPrizePool += entry.winnings;
+    stats.levelSum += entry.level;
+    stats.levelHistogram[min(max(entry.level, 0), LEADERBOARD_MAX_LEVEL)]++;
+}
+
+void Leaderboard::updateMedian()
+{
+    size_t n = stats.totalGames;
+    if (n == 0)
+        stats.medianWinnings = 0;
+    else if (n % 2 == 1)
+        stats.medianWinnings = winningsAt(n / 2);
+    else
+        stats.medianWinnings = (winningsAt(n / 2 - 1) + winningsAt(n / 2)) / 2;
+}
+
+long long Leaderboard::winningsAt(size_t position) const
+{
+    // Every tier is ordered by winnings, so with one tier this is a rank
+    // lookup; otherwise binary search the value whose count of better games
+    // covers position
+    if (segments.empty() && !frozen)
+        return entries.at(position).winnings;
+
+    vector<LeaderboardEntry> top;
+    collectTop(1, top);
+    long long low = 0, high = top.empty() ? 0 : top[0].winnings;
+    while (low < high)
+    {
+        long long middle = low + (high - low) / 2;
+        if (countBeforeAll({"", middle, INT_MAX, 0, 0}) <= position) // games winning more than middle
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+size_t Leaderboard::countBeforeAll(const LeaderboardEntry &entry) const
+{
+    size_t count = entries.countBefore(entry);
+    if (frozen)
+        count += lower_bound(frozen->begin(), frozen->end(), entry) - frozen->begin();
+    for (const auto &segment : segments)
+        count += segment->countBefore(entry);
+    return count;
+}
+
+void Leaderboard::collectTop(size_t count, vector<LeaderboardEntry> &out) const
 {
-    if (left < right)
+    // Oldest tier first, so the stable sort keeps equal games in insertion order
+    for (const auto &segment : segments)
     {
-        int mid = left + (right - left) / 2;
-        mergeSort(arr, left, mid);
-        mergeSort(arr, mid + 1, right);
-        merge(arr, left, mid, right);
+        for (size_t i = 0; i < min(count, segment->size()); i++)
+            out.push_back(segment->at(i));
     }
+    if (frozen)
+        out.insert(out.end(), frozen->begin(), frozen->begin() + min(count, frozen->size()));
+    entries.forEach([&](const LeaderboardEntry &entry)
+                    { out.push_back(entry); },
+                    count);
+    stable_sort(out.begin(), out.end());
+    if (out.size() > count)
+        out.resize(count);
 }
 
-void Leaderboard::merge(vector<LeaderboardEntry> &arr, int left, int mid, int right)
+void Leaderboard::recordAnswers(const vector<pair<int, bool>> &answers)
 {
-    vector<LeaderboardEntry> temp;
-    int i = left, j = mid + 1;
+    if (answers.empty())
+        return;
+    lock_guard<mutex> lock(entriesMutex);
+    for (const auto &answer : answers)
+    {
+        CategoryTally &tally = stats.categories[answer.first];
+        tally.asked++;
+        if (answer.second)
+            tally.correct++;
+    }
+    categoriesDirty = true;
+    publishStats();
+}
+
+bool Leaderboard::addToDay(const LeaderboardEntry &entry)
+{
+    if (entry.timestamp <= 0)
+        return false;
+    // A game stamped after today (a peer's clock running ahead, or an
+    // imported line) counts for today; only rollWindows moves the day on
+    long long day = min(dayOf(entry.timestamp), currentDay);
+    if (day <= currentDay - MONTH_DAYS)
+        return false;
+
+    auto bucket = lower_bound(days.begin(), days.end(), day,
+                              [](const DayBucket &b, long long d)
+                              { return b.day < d; });
+    if (bucket == days.end() || bucket->day != day)
+        bucket = days.insert(bucket, {day, {}});
+
+    vector<LeaderboardEntry> &top = bucket->top;
+    auto position = upper_bound(top.begin(), top.end(), entry);
+    if (position == top.end() && top.size() >= SNAPSHOT_SIZE)
+        return false;
+    top.insert(position, entry);
+    if (top.size() > SNAPSHOT_SIZE)
+        top.pop_back();
+    return true;
+}
 
-    while (i <= mid && j <= right)
+bool Leaderboard::addToPlayer(const LeaderboardEntry &entry)
+{
+    vector<LeaderboardEntry> &games = playerGames[entry.playerName];
+    games.insert(upper_bound(games.begin(), games.end(), entry), entry);
+
+    auto best = bestOf.find(entry.playerName);
+    if (best != bestOf.end() && !(entry < best->second))
+        return false;
+
+    bool changed = false;
+    if (best != bestOf.end())
+    {
+        // Equal scores of other players may sit before the old best
+        size_t old = playerBests.countBefore(best->second);
+        while (playerBests.at(old).playerName != entry.playerName)
+            old++;
+        playerBests.eraseAt(old);
+        changed = old < SNAPSHOT_SIZE;
+    }
+    bestOf[entry.playerName] = entry;
+    return playerBests.insert(entry) < SNAPSHOT_SIZE || changed;
+}
+
+void Leaderboard::advanceDay(long long day)
+{
+    currentDay = day;
+    while (!days.empty() && days.front().day <= currentDay - MONTH_DAYS)
+        days.pop_front();
+}
+
+void Leaderboard::buildWindow(LeaderboardWindow window, vector<LeaderboardEntry> &out) const
+{
+    long long span = window == LeaderboardWindow::TODAY ? 1 : (window == LeaderboardWindow::WEEK ? 7 : MONTH_DAYS);
+    for (const DayBucket &bucket : days)
     {
-        if (arr[i] < arr[j])
+        if (bucket.day > currentDay - span)
+            out.insert(out.end(), bucket.top.begin(), bucket.top.end());
+    }
+    // At most MONTH_DAYS * SNAPSHOT_SIZE games, however long the history
+    stable_sort(out.begin(), out.end());
+    if (out.size() > SNAPSHOT_SIZE)
+        out.resize(SNAPSHOT_SIZE);
+}
+
+void Leaderboard::publishSnapshot()
+{
+    auto next = make_shared<LeaderboardSnapshot>();
+    next->version = ++snapshotVersion;
+    next->stats = stats;
+    next->day = currentDay;
+
+    collectTop(SNAPSHOT_SIZE, next->top[(int)LeaderboardWindow::ALL_TIME]);
+    buildWindow(LeaderboardWindow::TODAY, next->top[(int)LeaderboardWindow::TODAY]);
+    buildWindow(LeaderboardWindow::WEEK, next->top[(int)LeaderboardWindow::WEEK]);
+    buildWindow(LeaderboardWindow::MONTH, next->top[(int)LeaderboardWindow::MONTH]);
+    next->players.reserve(min(playerBests.size(), SNAPSHOT_SIZE));
+    playerBests.forEach([&](const LeaderboardEntry &entry)
+                        { next->players.push_back(entry); },
+                        SNAPSHOT_SIZE);
+    atomic_store(&snapshot, shared_ptr<const LeaderboardSnapshot>(move(next)));
+}
+
+void Leaderboard::publishStats()
+{
+    shared_ptr<const LeaderboardSnapshot> current = atomic_load(&snapshot);
+    auto next = make_shared<LeaderboardSnapshot>(*current);
+    next->version = ++snapshotVersion;
+    next->stats = stats;
+    atomic_store(&snapshot, shared_ptr<const LeaderboardSnapshot>(move(next)));
+}
+
+void Leaderboard::rollWindows(long long now)
+{
+    lock_guard<mutex> lock(entriesMutex);
+    long long day = dayOf(now);
+    if (day <= currentDay)
+        return;
+    advanceDay(day);
+    publishSnapshot();
+}
+
+shared_ptr<const LeaderboardSnapshot> Leaderboard::getSnapshot() const
+{
+    return atomic_load(&snapshot);
+}
+
+void Leaderboard::saveToFile()
+{
+    vector<LeaderboardEntry> batch;
+    map<int, CategoryTally> categories;
+    bool categoriesChanged;
+    bool full;
+    {
+        // Held across the append so a rotation cannot slip between taking
+        // the batch and writing it
+        lock_guard<mutex> logLock(logMutex);
         {
-            temp.push_back(arr[i++]);
+            lock_guard<mutex> lock(entriesMutex);
+            batch.swap(unsaved);
+            categoriesChanged = categoriesDirty;
+            if (categoriesChanged)
+                categories = stats.categories;
+            categoriesDirty = false;
+            full = entries.size() >= MEMTABLE_LIMIT || frozen;
+        }
+        if (!batch.empty())
+            appendToLog(batch);
+        // Also under the log lock: saves from several threads share the temp
+        // file, and an older tally must not land after a newer one
+        if (categoriesChanged)
+            saveCategories(categories);
+    }
+    if (full)
+        startArchiving();
+}
+
+void Leaderboard::appendToLog(const vector<LeaderboardEntry> &batch) const
+{
+    ofstream file(filename, ios::app);
+    for (const auto &entry : batch)
+        file << formatEntry(entry) << "\n";
+    file.close();
+
+    if (file.fail())
+        cerr << "Error: Unable to save leaderboard to " << filename << endl;
+}
+
+string Leaderboard::segmentPath(uint64_t firstSeq, uint64_t lastSeq) const
+{
+    return archiveDir + "/" + to_string(firstSeq) + "-" + to_string(lastSeq) + ".lbs";
+}
+
+void Leaderboard::archiveExtent(uint64_t &lastSeq, uint64_t &games) const
+{
+    lastSeq = games = 0;
+    for (const auto &segment : segments)
+    {
+        lastSeq = max(lastSeq, segment->getFooter().lastSeq);
+        games += segment->size();
+    }
+}
+
+void Leaderboard::startArchiving()
+{
+    lock_guard<mutex> logLock(logMutex);
+    if (archiving)
+        return;
+    if (archiver.joinable())
+        archiver.join();
+
+    shared_ptr<const vector<LeaderboardEntry>> run;
+    uint64_t seq;
+    vector<LeaderboardEntry> pending;
+    bool rotate = false;
+    {
+        lock_guard<mutex> lock(entriesMutex);
+        if (frozen)
+        {
+            // The last attempt failed; its log is still rotated out, so retry it
+            run = frozen;
+            seq = frozenSeq;
         }
         else
         {
-            temp.push_back(arr[j++]);
+            if (entries.size() < MEMTABLE_LIMIT)
+                return;
+
+            // Only memory work here; queries see the run as frozen from now on
+            pending.swap(unsaved);
+            seq = nextSeq++;
+            auto sorted = make_shared<vector<LeaderboardEntry>>();
+            sorted->reserve(entries.size());
+            entries.forEach([&](const LeaderboardEntry &entry)
+                            { sorted->push_back(entry); });
+            entries.clear();
+            frozenGames = move(playerGames);
+            playerGames.clear();
+            frozen = sorted;
+            frozenSeq = seq;
+            run = move(sorted);
+            rotate = true;
         }
     }
 
-    while (i <= mid)
-        temp.push_back(arr[i++]);
-    while (j <= right)
-        temp.push_back(arr[j++]);
-
-    for (int i = left, k = 0; i <= right; i++, k++)
+    // Games not yet logged belong to this run, so they go in the log being
+    // rotated out with it. logMutex keeps saveToFile off the log meanwhile,
+    // while getRank and addEntry carry on.
+    if (rotate)
     {
-        arr[i] = temp[k];
+        appendToLog(pending);
+        error_code ec;
+        filesystem::rename(filename, filename + "." + to_string(seq), ec);
     }
+
+    archiving = true;
+    archiver = thread([this, run, seq]()
+                      {
+                          archiveRun(run, seq);
+                          mergeSegments();
+                          archiving = false; });
 }
 
-void Leaderboard::addEntry(const Player &player, const string &timestamp)
+void Leaderboard::archiveRun(shared_ptr<const vector<LeaderboardEntry>> run, uint64_t seq)
 {
-    // We ignore the timestamp argument now that it's removed from LeaderboardEntry
-    entries.push_back({player.name,
-                       player.totalWinnings,
-                       player.currentLevel,
-                       player.questionsAnswered});
+    string path = segmentPath(seq, seq);
+    size_t next = 0;
+    bool written = LeaderboardSegment::write(path, 0, seq, seq, [&](LeaderboardEntry &entry)
+                                             {
+                                                 if (next == run->size())
+                                                     return false;
+                                                 entry = (*run)[next++];
+                                                 return true; });
+    auto segment = make_shared<LeaderboardSegment>();
+    if (!written || !segment->open(path))
+        return; // stays frozen and is retried by the next save
 
-    if (entries.size() > MAX_ENTRIES)
     {
-        sortEntries();
-        entries.resize(MAX_ENTRIES);
-    }
+        // The run moves into the history in the same step it leaves the
+        // frozen tier, so getTopAt sees it exactly once. A history that is
+        // already behind is left for getTopAt to rebuild.
+        lock_guard<mutex> historyLock(historyMutex);
+        uint64_t lastSeq, games;
+        {
+            lock_guard<mutex> lock(entriesMutex);
+            archiveExtent(lastSeq, games);
+        }
+        if (history->covers(lastSeq, games) && history->extend(historyFilename, seq, games + run->size(), *run))
+        {
+            auto extended = make_unique<LeaderboardHistory>();
+            if (extended->open(historyFilename))
+                history = move(extended);
+        }
 
-    sortEntries();
-    saveToFile();
+        lock_guard<mutex> lock(entriesMutex);
+        segments.push_back(segment);
+        frozen.reset();
+        frozenGames.clear();
+    }
+    error_code ec;
+    filesystem::remove(filename + "." + to_string(seq), ec);
 }
 
-void Leaderboard::sortEntries()
+void Leaderboard::mergeSegments()
 {
-    if (entries.size() <= 1)
-        return;
-    mergeSort(entries, 0, entries.size() - 1);
+    for (;;)
+    {
+        // Levels only decrease from oldest to newest, so a full level is a
+        // contiguous block
+        vector<shared_ptr<const LeaderboardSegment>> inputs;
+        {
+            lock_guard<mutex> lock(entriesMutex);
+            for (size_t first = 0; first < segments.size() && inputs.empty();)
+            {
+                size_t last = first;
+                while (last < segments.size() && segments[last]->getFooter().level == segments[first]->getFooter().level)
+                    last++;
+                if (last - first >= MERGE_FANIN)
+                    inputs.assign(segments.begin() + first, segments.begin() + first + MERGE_FANIN);
+                first = last;
+            }
+        }
+        if (inputs.empty())
+            return;
+
+        // k-way heap merge; equal games come out oldest segment first
+        struct Cursor
+        {
+            LeaderboardEntry entry;
+            size_t input;
+            size_t position;
+        };
+        auto after = [](const Cursor &a, const Cursor &b)
+        {
+            if (b.entry < a.entry)
+                return true;
+            return !(a.entry < b.entry) && a.input > b.input;
+        };
+        priority_queue<Cursor, vector<Cursor>, decltype(after)> heap(after);
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (inputs[i]->size() > 0)
+                heap.push({inputs[i]->at(0), i, 0});
+        }
+
+        uint32_t level = inputs.front()->getFooter().level + 1;
+        uint64_t firstSeq = inputs.front()->getFooter().firstSeq;
+        uint64_t lastSeq = inputs.back()->getFooter().lastSeq;
+        string path = segmentPath(firstSeq, lastSeq);
+        bool written = LeaderboardSegment::write(path, level, firstSeq, lastSeq, [&](LeaderboardEntry &entry)
+                                                 {
+                                                     if (heap.empty())
+                                                         return false;
+                                                     Cursor top = heap.top();
+                                                     heap.pop();
+                                                     entry = move(top.entry);
+                                                     if (++top.position < inputs[top.input]->size())
+                                                         heap.push({inputs[top.input]->at(top.position), top.input, top.position});
+                                                     return true; });
+        auto merged = make_shared<LeaderboardSegment>();
+        if (!written || !merged->open(path))
+            return;
+
+        {
+            lock_guard<mutex> lock(entriesMutex);
+            auto first = find(segments.begin(), segments.end(), inputs.front());
+            first = segments.erase(first, first + inputs.size());
+            segments.insert(first, merged);
+        }
+        // Readers still holding an input keep its mapping; the files can go
+        for (const auto &input : inputs)
+        {
+            error_code ec;
+            filesystem::remove(input->getPath(), ec);
+        }
+    }
 }
 
-void Leaderboard::saveToFile() const
+void Leaderboard::openArchive()
 {
-    ofstream file(filename);
-    for (const auto &entry : entries)
+    error_code ec;
+    filesystem::create_directories(archiveDir, ec);
+
+    vector<shared_ptr<LeaderboardSegment>> found;
+    for (const auto &file : filesystem::directory_iterator(archiveDir, ec))
     {
-        // Saving 4 fields: playerName, winnings, level, gamesPlayed
-        file << entry.playerName << "|" << entry.winnings << "|"
-             << entry.level << "|"
-             << entry.gamesPlayed << "\n";
+        string path = file.path().string();
+        if (file.path().extension() == ".tmp")
+        {
+            filesystem::remove(file.path(), ec);
+            continue;
+        }
+        if (file.path().extension() != ".lbs")
+            continue;
+        auto segment = make_shared<LeaderboardSegment>();
+        if (segment->open(path))
+            found.push_back(segment);
+        else
+            cerr << "Error: Skipping unreadable leaderboard segment " << path << endl;
     }
+
+    // A merge that was interrupted before removing its inputs leaves them
+    // beside the merged segment; the merged one covers their flushes
+    sort(found.begin(), found.end(), [](const shared_ptr<LeaderboardSegment> &a, const shared_ptr<LeaderboardSegment> &b)
+         {
+             if (a->getFooter().firstSeq != b->getFooter().firstSeq)
+                 return a->getFooter().firstSeq < b->getFooter().firstSeq;
+             return a->getFooter().lastSeq > b->getFooter().lastSeq; });
+    vector<shared_ptr<const LeaderboardSegment>> kept;
+    uint64_t covered = 0;
+    for (const auto &segment : found)
+    {
+        if (segment->getFooter().lastSeq <= covered)
+        {
+            filesystem::remove(segment->getPath(), ec);
+            continue;
+        }
+        covered = segment->getFooter().lastSeq;
+        kept.push_back(segment);
+    }
+
+    // Logs rotated out for a flush: drop them if the segment made it,
+    // otherwise fold them back into the live log
+    string prefix = filesystem::path(filename).filename().string() + ".";
+    for (const auto &file : filesystem::directory_iterator(filesystem::path(filename).parent_path(), ec))
+    {
+        string name = file.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0 || name.size() == prefix.size() ||
+            name.find_first_not_of("0123456789", prefix.size()) != string::npos)
+            continue;
+        uint64_t seq = stoull(name.substr(prefix.size()));
+        covered = max(covered, seq);
+        bool archived = any_of(kept.begin(), kept.end(), [&](const shared_ptr<const LeaderboardSegment> &segment)
+                               { return segment->getFooter().firstSeq <= seq && seq <= segment->getFooter().lastSeq; });
+        if (!archived)
+        {
+            ifstream rotated(file.path());
+            ofstream live(filename, ios::app);
+            live << rotated.rdbuf();
+            live.close();
+            if (live.fail())
+            {
+                cerr << "Error: Unable to recover " << file.path().string() << endl;
+                continue;
+            }
+        }
+        filesystem::remove(file.path(), ec);
+    }
+
+    // Checked against the segments on first use
+    auto opened = make_unique<LeaderboardHistory>();
+    opened->open(historyFilename);
+
+    lock_guard<mutex> historyLock(historyMutex);
+    history = move(opened);
+    lock_guard<mutex> lock(entriesMutex);
+    segments = move(kept);
+    nextSeq = covered + 1;
+}
+
+void Leaderboard::saveCategories(const map<int, CategoryTally> &categories) const
+{
+    // Small enough to rewrite whole; the rename keeps the old file until the new one is complete
+    string tempName = categoryFilename + ".tmp";
+    ofstream file(tempName, ios::trunc);
+    for (const auto &category : categories)
+        file << category.first << "|" << category.second.asked << "|" << category.second.correct << "\n";
     file.close();
+
+    error_code ec;
+    if (!file.fail())
+        filesystem::rename(tempName, categoryFilename, ec);
+    if (file.fail() || ec)
+    {
+        cerr << "Error: Unable to save category stats to " << categoryFilename << endl;
+        filesystem::remove(tempName, ec);
+    }
 }
 
-void Leaderboard::loadFromFile()
+void Leaderboard::loadCategories()
 {
-    ifstream file(filename);
+    ifstream file(categoryFilename);
     if (!file.is_open())
         return;
 
+    map<int, CategoryTally> categories;
     string line;
     while (getline(file, line))
     {
-        if (line.empty())
-            continue;
-
         vector<string> tokens;
         stringstream ss(line);
         string token;
-
         while (getline(ss, token, '|'))
-        {
             tokens.push_back(token);
-        }
 
-        // Checking for exactly 4 tokens now
-        if (tokens.size() == 4)
+        if (tokens.size() == 3)
+            categories[stoi(tokens[0])] = {stoll(tokens[1]), stoll(tokens[2])};
+    }
+
+    lock_guard<mutex> lock(entriesMutex);
+    stats.categories = move(categories);
+    categoriesDirty = false;
+    publishStats();
+}
+
+string Leaderboard::formatEntry(const LeaderboardEntry &entry)
+{
+    // 5 fields: playerName, winnings, level, gamesPlayed, timestamp
+    return entry.playerName + "|" + to_string(entry.winnings) + "|" + to_string(entry.level) + "|" +
+           to_string(entry.gamesPlayed) + "|" + to_string(entry.timestamp);
+}
+
+bool Leaderboard::parseEntry(const string &line, LeaderboardEntry &entry)
+{
+    if (line.empty())
+        return false;
+
+    vector<string> tokens;
+    stringstream ss(line);
+    string token;
+
+    while (getline(ss, token, '|'))
+    {
+        tokens.push_back(token);
+    }
+
+    // 4 fields in files written before timestamps were kept
+    if (tokens.size() != 4 && tokens.size() != 5)
+        return false;
+    try
+    {
+        entry = {tokens[0],
+                 stoll(tokens[1]),
+                 stoi(tokens[2]),
+                 stoi(tokens[3]),
+                 tokens.size() == 5 ? stoll(tokens[4]) : 0};
+    }
+    catch (const exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+void Leaderboard::loadFromFile()
+{
+    loadCategories();
+    if (archiver.joinable())
+        archiver.join();
+    openArchive();
+
+    vector<LeaderboardEntry> loaded;
+    ifstream file(filename);
+    string line;
+    LeaderboardEntry entry;
+    while (file.is_open() && getline(file, line))
+    {
+        if (parseEntry(line, entry))
+            loaded.push_back(entry);
+    }
+    file.close();
+
+    rebuild(move(loaded));
+}
+
+void Leaderboard::rebuild(vector<LeaderboardEntry> &&games, unsigned threads)
+{
+    MergeSorter<LeaderboardEntry>::sort(games, threads);
+    if (archiver.joinable())
+        archiver.join();
+
+    lock_guard<mutex> lock(entriesMutex);
+    days.clear();
+    playerGames.clear();
+    frozenGames.clear();
+    bestOf.clear();
+    map<int, CategoryTally> categories = move(stats.categories);
+    stats = LeaderboardStats();
+    stats.categories = move(categories);
+
+    auto offerBest = [&](const LeaderboardEntry &game)
+    {
+        auto best = bestOf.find(game.playerName);
+        if (best == bestOf.end())
+            bestOf.emplace(game.playerName, game);
+        else if (game < best->second)
+            best->second = game;
+    };
+
+    // Segments contribute their stored totals; only recent ones are read
+    // for the day buckets
+    long long monthStart = (currentDay - MONTH_DAYS + 1) * SECONDS_PER_DAY;
+    for (const auto &segment : segments)
+    {
+        const SegmentFooter &footer = segment->getFooter();
+        stats.totalGames += footer.count;
+        stats.totalPrizePool += footer.totalPrizePool;
+        stats.levelSum += footer.levelSum;
+        for (int level = 0; level <= LEADERBOARD_MAX_LEVEL; level++)
+            stats.levelHistogram[level] += footer.levelHistogram[level];
+        if (footer.maxTimestamp >= monthStart)
         {
-            entries.push_back({
-                tokens[0],
-                stoll(tokens[1]),
-                stoi(tokens[2]),
-                stoi(tokens[3]) 
-            });
+            for (size_t i = 0; i < segment->size(); i++)
+                addToDay(segment->at(i));
         }
+        segment->forEachPlayerBest([&](size_t position)
+                                   { offerBest(segment->at(position)); });
     }
-    file.close();
-    sortEntries();
+
+    for (const LeaderboardEntry &game : games)
+    {
+        countGame(game);
+        addToDay(game);
+        playerGames[game.playerName].push_back(game);
+        offerBest(game);
+    }
+
+    vector<LeaderboardEntry> bests;
+    bests.reserve(bestOf.size());
+    for (const auto &best : bestOf)
+        bests.push_back(best.second);
+    stable_sort(bests.begin(), bests.end());
+    playerBests.assignSorted(move(bests));
+    entries.assignSorted(move(games));
+    updateMedian();
+    unsaved.clear();
+    publishSnapshot();
 }
 
-const vector<LeaderboardEntry> &Leaderboard::getTopEntries(int count) const
+vector<LeaderboardEntry> Leaderboard::getTopEntries(int count, LeaderboardWindow window) const
 {
-    static vector<LeaderboardEntry> top;
-    top.clear();
-    for (int i = 0; i < min(count, (int)entries.size()); i++)
+    // Windowed boards only exist as far as the snapshot goes
+    if (count >= 0 && ((size_t)count <= SNAPSHOT_SIZE || window != LeaderboardWindow::ALL_TIME))
     {
-        top.push_back(entries[i]);
+        shared_ptr<const LeaderboardSnapshot> current = getSnapshot();
+        const vector<LeaderboardEntry> &top = current->getTop(window);
+        size_t n = min((size_t)count, top.size());
+        return vector<LeaderboardEntry>(top.begin(), top.begin() + n);
     }
+
+    lock_guard<mutex> lock(entriesMutex);
+    vector<LeaderboardEntry> top;
+    collectTop((size_t)max(count, 0), top);
     return top;
 }
 
+vector<LeaderboardEntry> Leaderboard::getTopAt(long long timestamp, int count) const
+{
+    size_t wanted = min((size_t)max(count, 0), LeaderboardHistory::DEPTH);
+    if (wanted == 0)
+        return {};
+    auto qualifies = [timestamp](const LeaderboardEntry &game)
+    { return game.timestamp <= timestamp; };
+
+    // Held throughout, so the archiver cannot move the frozen run into the
+    // history between reading one and the other
+    lock_guard<mutex> historyLock(historyMutex);
+    vector<shared_ptr<const LeaderboardSegment>> archived;
+    shared_ptr<const vector<LeaderboardEntry>> run;
+    vector<LeaderboardEntry> unarchived;
+    uint64_t lastSeq, games;
+    {
+        // Each recent tier is best first, so only its first wanted games
+        // played by then can be on the board
+        lock_guard<mutex> lock(entriesMutex);
+        archived = segments;
+        run = frozen;
+        archiveExtent(lastSeq, games);
+        entries.forEachWhile([&](const LeaderboardEntry &game)
+                             {
+                                 if (qualifies(game))
+                                     unarchived.push_back(game);
+                                 return unarchived.size() < wanted; });
+    }
+    size_t recent = unarchived.size();
+    for (size_t i = 0; run && i < run->size() && unarchived.size() - recent < wanted; i++)
+    {
+        if (qualifies((*run)[i]))
+            unarchived.push_back((*run)[i]);
+    }
+
+    // First query after an upgrade, an offline merge or a crash between a
+    // segment and its history: replayed from the segments once and kept
+    if (!history->covers(lastSeq, games))
+    {
+        auto rebuilt = make_unique<LeaderboardHistory>();
+        if (LeaderboardHistory::build(historyFilename, archived) && rebuilt->open(historyFilename))
+            history = move(rebuilt);
+        else
+            cerr << "Error: Leaderboard history is behind the archive" << endl;
+    }
+    return history->topAt(timestamp, wanted, unarchived);
+}
+
 vector<LeaderboardEntry> Leaderboard::getPlayerHistory(const string &playerName) const
 {
+    lock_guard<mutex> lock(entriesMutex);
     vector<LeaderboardEntry> history;
-    for (const auto &entry : entries)
+    for (const auto &segment : segments)
+        segment->findPlayer(playerName, history);
+    for (const auto *index : {&frozenGames, &playerGames})
     {
-        if (entry.playerName == playerName)
-        {
-            history.push_back(entry);
-        }
+        auto found = index->find(playerName);
+        if (found != index->end())
+            history.insert(history.end(), found->second.begin(), found->second.end());
     }
+    stable_sort(history.begin(), history.end());
     return history;
 }
 
-int Leaderboard::getTotalGames() const { return entries.size(); }
-
-long long Leaderboard::getTotalPrizePool() const
+vector<LeaderboardEntry> Leaderboard::getTopPlayers(int count) const
 {
-    long long total = 0;
-    for (const auto &entry : entries)
+    if (count >= 0 && (size_t)count <= SNAPSHOT_SIZE)
     {
-        total += entry.winnings;
+        shared_ptr<const LeaderboardSnapshot> current = getSnapshot();
+        size_t n = min((size_t)count, current->players.size());
+        return vector<LeaderboardEntry>(current->players.begin(), current->players.begin() + n);
     }
-    return total;
+
+    lock_guard<mutex> lock(entriesMutex);
+    vector<LeaderboardEntry> top;
+    playerBests.forEach([&](const LeaderboardEntry &entry)
+                        { top.push_back(entry); },
+                        (size_t)max(count, 0));
+    return top;
+}
+
+int Leaderboard::getPlayerCount() const
+{
+    lock_guard<mutex> lock(entriesMutex);
+    return (int)playerBests.size();
+}
+
+int Leaderboard::getRank(const LeaderboardEntry &entry) const
+{
+    lock_guard<mutex> lock(entriesMutex);
+    return (int)countBeforeAll(entry) + 1;
+}
+
+int Leaderboard::getTotalGames() const
+{
+    return (int)getSnapshot()->stats.totalGames;
+}
+
+long long Leaderboard::getTotalPrizePool() const
+{
+    return getSnapshot()->stats.totalPrizePool;
 }
 
 int Leaderboard::getAverageLevel() const
 {
-    if (entries.empty())
-        return 0;
-    int sum = 0;
-    for (const auto &entry : entries)
-    {
-        sum += entry.level;
-    }
-    return sum / entries.size();
+    return getSnapshot()->stats.getAverageLevel();
 }
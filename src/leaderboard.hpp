@@ -2,11 +2,21 @@
 #define LEADERBOARD_HPP
 
 #include "data_structures.hpp"
+#include "rank_tree.hpp"
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <map>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 
@@ -16,6 +26,7 @@ struct LeaderboardEntry
     long long winnings;
     int level;
     int gamesPlayed;
+    long long timestamp; // unix seconds; 0 for games saved before timestamps were kept
 
     bool operator<(const LeaderboardEntry &other) const
     {
@@ -30,31 +41,175 @@ struct LeaderboardEntry
     }
 };
 
+enum class LeaderboardWindow
+{
+    ALL_TIME,
+    TODAY,  // current UTC day
+    WEEK,   // last 7 UTC days, today included
+    MONTH   // last 30 UTC days, today included
+};
+
+static constexpr int LEADERBOARD_WINDOWS = 4;
+
+struct CategoryTally
+{
+    long long asked;
+    long long correct;
+};
+
+// All-time aggregates, updated as each game is added rather than recomputed
+static constexpr int LEADERBOARD_MAX_LEVEL = 15;
+
+struct LeaderboardStats
+{
+    size_t totalGames = 0;
+    long long totalPrizePool = 0;
+    long long levelSum = 0;
+    long long medianWinnings = 0;
+    array<size_t, LEADERBOARD_MAX_LEVEL + 1> levelHistogram{}; // games by final level
+    map<int, CategoryTally> categories;                          // answers by question category
+
+    int getAverageLevel() const { return totalGames ? (int)(levelSum / (long long)totalGames) : 0; }
+    double getWinRate(int category) const; // share of answers correct, 0 if none
+};
+
+// Immutable view of the best games, republished whenever they change. Readers
+// keep whichever version they loaded for as long as they hold the pointer.
+struct LeaderboardSnapshot
+{
+    uint64_t version;
+    LeaderboardStats stats;
+    long long day; // UTC day the windowed boards were built for
+    vector<LeaderboardEntry> top[LEADERBOARD_WINDOWS]; // by LeaderboardWindow, best first, at most Leaderboard::SNAPSHOT_SIZE
+    vector<LeaderboardEntry> players;                  // all time, each player's best game only
+
+    const vector<LeaderboardEntry> &getTop(LeaderboardWindow window) const { return top[(int)window]; }
+};
+
+class LeaderboardSegment;
+class LeaderboardHistory;
+
+// Every game ever played, in two tiers. Recent games are ranked best first in
+// an order-statistic tree (O(log n) insert and rank); the file is an unsorted
+// log of just those games. Once MEMTABLE_LIMIT accumulate they are frozen and
+// written on a background thread as an immutable sorted segment under
+// docs/leaderboard_archive, and every MERGE_FANIN segments of one level are
+// merged into one of the next, so a query visits O(log n) segments. Rank,
+// history and top-K queries cover both tiers; memory holds only the recent
+// tier plus per-player bests and the windowed buckets.
+// Thread safe: games are recorded by the persistence worker while the
+// renderer reads the board; the renderer reads published snapshots and never
+// waits on the writer.
+// Windowed boards come from one bucket per UTC day holding that day's top
+// SNAPSHOT_SIZE games, so they cost O(days * K) to rebuild whatever the
+// history size. Buckets older than a month are dropped as days roll over.
+// Each player's recent games are also indexed by name (segments carry their
+// own name index), and their best games kept in a second tree, so history is
+// O(k + segments * log n) and the one-row-per-player board is as cheap as
+// the main one. Boards as they stood at past moments come from a history
+// file the archiver extends beside the segments, plus a scan of the recent
+// tier.
 class Leaderboard
 {
 private:
-    vector<LeaderboardEntry> entries;
- 
-    const string filename = "docs/leaderboard.txt";
+    RankTree<LeaderboardEntry> entries; // recent tier
+    vector<LeaderboardEntry> unsaved;   // added since the last saveToFile
+    mutable mutex entriesMutex;
 
-    static constexpr int MAX_ENTRIES = 100;
-    static constexpr int TOP_DISPLAY = 5;
+    shared_ptr<const vector<LeaderboardEntry>> frozen;    // sorted run being archived, or null
+    uint64_t frozenSeq;
+    vector<shared_ptr<const LeaderboardSegment>> segments; // archived tier, oldest first
+    uint64_t nextSeq;                                      // number of the next flush
+    mutex logMutex;                                        // log appends and rotation; taken before entriesMutex
+    thread archiver;
+    atomic<bool> archiving;
+    shared_ptr<const LeaderboardSnapshot> snapshot; // only touched through atomic_load / atomic_store
+    uint64_t snapshotVersion;                       // guarded by entriesMutex
 
-    void mergeSort(vector<LeaderboardEntry> &arr, int left, int right);
-    void merge(vector<LeaderboardEntry> &arr, int left, int mid, int right);
+    struct DayBucket
+    {
+        long long day;
+        vector<LeaderboardEntry> top; // best first, at most SNAPSHOT_SIZE
+    };
+    deque<DayBucket> days; // ascending, only the last MONTH_DAYS
+    long long currentDay;
 
+    unordered_map<string, vector<LeaderboardEntry>> playerGames; // recent tier, best first
+    unordered_map<string, vector<LeaderboardEntry>> frozenGames; // frozen run, best first
+    unordered_map<string, LeaderboardEntry> bestOf;              // every tier
+    RankTree<LeaderboardEntry> playerBests;                       // one entry per player
 
+    // The archived games' board history; getTopAt rebuilds it if it is behind
+    // the segments. historyMutex is taken before entriesMutex.
+    mutable unique_ptr<LeaderboardHistory> history;
+    mutable mutex historyMutex;
+
+    LeaderboardStats stats; // what the next snapshot publishes
+    bool categoriesDirty;   // categories changed since the last saveToFile
+    const string filename = "docs/leaderboard.txt";
+    const string categoryFilename = "docs/category_stats.txt";
+    const string archiveDir = "docs/leaderboard_archive";
+    const string historyFilename = "docs/leaderboard_archive/history.lbh";
+
+    void publishSnapshot(); // caller holds entriesMutex
+    void publishStats();    // same boards, new stats; caller holds entriesMutex
+    void countGame(const LeaderboardEntry &entry); // caller holds entriesMutex
+    void updateMedian();                           // caller holds entriesMutex
+    void loadCategories();
+    void saveCategories(const map<int, CategoryTally> &categories) const;
+    bool addToDay(const LeaderboardEntry &entry); // true if it made its day's top; caller holds entriesMutex
+    void advanceDay(long long day);                // drops expired buckets; caller holds entriesMutex
+    void buildWindow(LeaderboardWindow window, vector<LeaderboardEntry> &out) const;
+    bool addToPlayer(const LeaderboardEntry &entry); // true if the published player board changed; caller holds entriesMutex
+
+    // Tiers; callers hold entriesMutex unless noted
+    size_t countBeforeAll(const LeaderboardEntry &entry) const;
+    void collectTop(size_t count, vector<LeaderboardEntry> &out) const;
+    long long winningsAt(size_t position) const; // position < stats.totalGames
+    void appendToLog(const vector<LeaderboardEntry> &batch) const; // caller holds logMutex
+    string segmentPath(uint64_t firstSeq, uint64_t lastSeq) const;
+    void archiveExtent(uint64_t &lastSeq, uint64_t &games) const; // newest flush and game count archived
+    void openArchive();     // at load, before the log is read
+    void startArchiving();  // takes logMutex
+    void archiveRun(shared_ptr<const vector<LeaderboardEntry>> run, uint64_t seq); // archiver thread
+    void mergeSegments();   // archiver thread
 
 public:
+    static constexpr size_t SNAPSHOT_SIZE = 10;
+    static constexpr long long SECONDS_PER_DAY = 86400;
+    static constexpr long long MONTH_DAYS = 30;
+    static constexpr size_t MEMTABLE_LIMIT = 32768;
+    static constexpr size_t MERGE_FANIN = 4;
+
+    static long long dayOf(long long timestamp);
+    static string formatEntry(const LeaderboardEntry &entry);            // one log line, without the newline
+    static bool parseEntry(const string &line, LeaderboardEntry &entry); // one log line; false if malformed
+
     Leaderboard();
+    ~Leaderboard();
+
+    Leaderboard(const Leaderboard &) = delete;
+    Leaderboard &operator=(const Leaderboard &) = delete;
 
-    void addEntry(const Player &player, const string &timestamp);
-    void sortEntries();
-    void saveToFile() const;
+    void addEntry(const Player &player, long long timestamp);
+    void addEntry(const LeaderboardEntry &entry); // in memory only; saveToFile persists
+    void recordAnswers(const vector<pair<int, bool>> &answers); // (category, correct) per question
+    void saveToFile(); // appends the entries added since the last call; archives a full recent tier
     void loadFromFile();
+    // Replaces the recent tier with games in one parallel sort (threads = 0
+    // uses every core) and reindexes the archive. Nothing is written; the
+    // log is expected to hold them.
+    void rebuild(vector<LeaderboardEntry> &&games, unsigned threads = 0);
 
-    const vector<LeaderboardEntry> &getTopEntries(int count = 5) const;
-    vector<LeaderboardEntry> getPlayerHistory(const string &playerName) const;
+    shared_ptr<const LeaderboardSnapshot> getSnapshot() const; // lock free, never null; stats are in ->stats
+    void rollWindows(long long now); // call periodically so windows expire without new games
+    vector<LeaderboardEntry> getTopEntries(int count = 5, LeaderboardWindow window = LeaderboardWindow::ALL_TIME) const;
+    // The all-time board as it stood at timestamp, up to LeaderboardHistory::DEPTH places
+    vector<LeaderboardEntry> getTopAt(long long timestamp, int count = 5) const;
+    vector<LeaderboardEntry> getPlayerHistory(const string &playerName) const; // best first
+    vector<LeaderboardEntry> getTopPlayers(int count = 5) const;               // each player's best game
+    int getPlayerCount() const;
+    int getRank(const LeaderboardEntry &entry) const; // 1 + games strictly better
 
     int getTotalGames() const;
     long long getTotalPrizePool() const;
@@ -0,0 +1,239 @@
+#include "leaderboard_history.hpp"
+#include "append_file.hpp"
+#include "rank_tree.hpp"
+#include <filesystem>
+#include <cstring>
+
+using namespace std;
+
+// Board order, then earlier games first so the result doesn't depend on the
+// order games arrived in
+static bool placedBefore(const LeaderboardEntry &a, const LeaderboardEntry &b)
+{
+    if (a < b)
+        return true;
+    return !(b < a) && a.timestamp < b.timestamp;
+}
+
+// Replay order: by timestamp, then as placed
+static bool replayedBefore(const LeaderboardEntry &a, const LeaderboardEntry &b)
+{
+    if (a.timestamp != b.timestamp)
+        return a.timestamp < b.timestamp;
+    return placedBefore(a, b);
+}
+
+// Inserts game into a best-first board of at most DEPTH; false if it misses
+template <typename Placed, typename Entry>
+static bool placeOnBoard(vector<Placed> &board, const LeaderboardEntry &game, Placed placed, Entry entryOf)
+{
+    auto position = upper_bound(board.begin(), board.end(), game, [&](const LeaderboardEntry &value, const Placed &other)
+                                { return placedBefore(value, entryOf(other)); });
+    if ((size_t)(position - board.begin()) >= LeaderboardHistory::DEPTH)
+        return false;
+    board.insert(position, move(placed));
+    if (board.size() > LeaderboardHistory::DEPTH)
+        board.pop_back();
+    return true;
+}
+
+LeaderboardHistory::LeaderboardHistory() : footer(), records(nullptr), checkpoints(nullptr) {}
+
+bool LeaderboardHistory::open(const string &filename)
+{
+    if (!file.open(filename) || file.size() < sizeof(HistoryFooter))
+        return false;
+
+    HistoryFooter found;
+    memcpy(&found, file.data() + file.size() - sizeof(HistoryFooter), sizeof(HistoryFooter));
+    if (memcmp(found.magic, LBHIST_MAGIC, sizeof(LBHIST_MAGIC)) != 0 || found.version != LBHIST_VERSION)
+        return false;
+    if (found.count > file.size() || found.checkpoints > file.size() ||
+        found.count * sizeof(SegmentRecord) + found.checkpoints * sizeof(HistoryCheckpoint) + sizeof(HistoryFooter) != file.size())
+        return false;
+
+    const HistoryCheckpoint *marks = reinterpret_cast<const HistoryCheckpoint *>(file.data() + found.count * sizeof(SegmentRecord));
+    for (uint64_t i = 0; i < found.checkpoints; i++)
+    {
+        if (marks[i].next > found.count || marks[i].count > DEPTH)
+            return false;
+        for (uint32_t slot = 0; slot < marks[i].count; slot++)
+        {
+            if (marks[i].board[slot] >= marks[i].next)
+                return false;
+        }
+    }
+
+    footer = found;
+    records = reinterpret_cast<const SegmentRecord *>(file.data());
+    checkpoints = marks;
+    return true;
+}
+
+bool LeaderboardHistory::covers(uint64_t seq, uint64_t games) const
+{
+    return footer.coveredSeq == seq && footer.coveredGames == games;
+}
+
+vector<LeaderboardEntry> LeaderboardHistory::topAt(long long timestamp, size_t count,
+                                                   const vector<LeaderboardEntry> &unarchived) const
+{
+    // Start from the last checkpoint at or before timestamp
+    vector<LeaderboardEntry> board;
+    const HistoryCheckpoint *last = checkpoints + footer.checkpoints;
+    const HistoryCheckpoint *mark = upper_bound(checkpoints, last, timestamp,
+                                                [](long long time, const HistoryCheckpoint &checkpoint)
+                                                { return time < checkpoint.timestamp; });
+    uint64_t next = 0;
+    if (mark != checkpoints)
+    {
+        --mark;
+        for (uint32_t slot = 0; slot < mark->count; slot++)
+            board.push_back(LeaderboardSegment::fromRecord(records[mark->board[slot]]));
+        next = mark->next;
+    }
+
+    auto entryOf = [](const LeaderboardEntry &entry) -> const LeaderboardEntry &
+    { return entry; };
+    for (; next < footer.count && records[next].timestamp <= timestamp; next++)
+    {
+        LeaderboardEntry game = LeaderboardSegment::fromRecord(records[next]);
+        placeOnBoard(board, game, game, entryOf);
+    }
+    for (const LeaderboardEntry &game : unarchived)
+    {
+        if (game.timestamp <= timestamp)
+            placeOnBoard(board, game, game, entryOf);
+    }
+
+    if (board.size() > count)
+        board.resize(count);
+    return board;
+}
+
+bool LeaderboardHistory::write(const string &filename, uint64_t coveredSeq, uint64_t coveredGames,
+                               const function<bool(LeaderboardEntry &)> &next)
+{
+    const string tempFile = filename + ".tmp";
+    error_code ec;
+    filesystem::remove(tempFile, ec);
+
+    HistoryFooter written = {};
+    memcpy(written.magic, LBHIST_MAGIC, sizeof(LBHIST_MAGIC));
+    written.version = LBHIST_VERSION;
+    written.coveredSeq = coveredSeq;
+    written.coveredGames = coveredGames;
+
+    // The board as replayed so far, with each game's record number
+    using Placed = pair<LeaderboardEntry, uint32_t>;
+    vector<Placed> board;
+    auto entryOf = [](const Placed &placed) -> const LeaderboardEntry &
+    { return placed.first; };
+    vector<HistoryCheckpoint> marks;
+
+    AppendFile out;
+    bool ok = out.open(tempFile);
+    string chunk;
+    LeaderboardEntry game;
+    while (ok && next(game))
+    {
+        // A game that misses the board as it stood then misses every later one
+        if (!placeOnBoard(board, game, Placed(game, (uint32_t)written.count), entryOf))
+            continue;
+        SegmentRecord record = LeaderboardSegment::toRecord(game);
+        chunk.append(reinterpret_cast<const char *>(&record), sizeof(record));
+        written.count++;
+
+        if (written.count % CHECKPOINT_EVERY == 0)
+        {
+            HistoryCheckpoint mark = {};
+            mark.timestamp = game.timestamp;
+            mark.next = written.count;
+            mark.count = (uint32_t)board.size();
+            for (size_t slot = 0; slot < board.size(); slot++)
+                mark.board[slot] = board[slot].second;
+            marks.push_back(mark);
+        }
+        if (chunk.size() >= 65536)
+        {
+            ok = out.append(chunk);
+            chunk.clear();
+        }
+    }
+    written.checkpoints = marks.size();
+    ok = ok && out.append(chunk) &&
+         out.append(string_view(reinterpret_cast<const char *>(marks.data()), marks.size() * sizeof(HistoryCheckpoint))) &&
+         out.append(string_view(reinterpret_cast<const char *>(&written), sizeof(written))) &&
+         out.sync();
+    out.close();
+
+    if (ok)
+        filesystem::rename(tempFile, filename, ec);
+    if (!ok || ec)
+    {
+        cerr << "Error: Unable to write leaderboard history " << filename << endl;
+        filesystem::remove(tempFile, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LeaderboardHistory::extend(const string &filename, uint64_t seq, uint64_t games,
+                                const vector<LeaderboardEntry> &run) const
+{
+    vector<LeaderboardEntry> added = run;
+    stable_sort(added.begin(), added.end(), replayedBefore);
+
+    // Both are in replay order, so they merge in one pass
+    uint64_t old = 0;
+    size_t fresh = 0;
+    return write(filename, seq, games, [&](LeaderboardEntry &game)
+                 {
+                     if (old < footer.count)
+                     {
+                         LeaderboardEntry kept = LeaderboardSegment::fromRecord(records[old]);
+                         if (fresh == added.size() || !replayedBefore(added[fresh], kept))
+                         {
+                             game = move(kept);
+                             old++;
+                             return true;
+                         }
+                     }
+                     if (fresh == added.size())
+                         return false;
+                     game = move(added[fresh++]);
+                     return true; });
+}
+
+bool LeaderboardHistory::build(const string &filename, const vector<shared_ptr<const LeaderboardSegment>> &segments)
+{
+    // A game that made the board of the whole archive also made its own
+    // segment's. Segments are best first, so that is a game with fewer than
+    // DEPTH earlier records played before it, counted over a tree of the
+    // timestamps kept so far; the writer drops the rest.
+    vector<LeaderboardEntry> candidates;
+    uint64_t seq = 0, games = 0;
+    for (const auto &segment : segments)
+    {
+        RankTree<long long> kept;
+        for (size_t i = 0; i < segment->size(); i++)
+        {
+            LeaderboardEntry game = segment->at(i);
+            if (kept.countBefore(game.timestamp) >= DEPTH)
+                continue;
+            kept.insert(game.timestamp);
+            candidates.push_back(move(game));
+        }
+        seq = max(seq, segment->getFooter().lastSeq);
+        games += segment->size();
+    }
+    stable_sort(candidates.begin(), candidates.end(), replayedBefore);
+
+    size_t next = 0;
+    return write(filename, seq, games, [&](LeaderboardEntry &game)
+                 {
+                     if (next == candidates.size())
+                         return false;
+                     game = move(candidates[next++]);
+                     return true; });
+}
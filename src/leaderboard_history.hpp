@@ -0,0 +1,85 @@
+#ifndef LEADERBOARD_HISTORY_HPP
+#define LEADERBOARD_HISTORY_HPP
+
+#include "leaderboard.hpp"
+#include "leaderboard_segment.hpp"
+#include "mapped_file.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// The all-time board as it stood at every moment, for questions like "who
+// led at 6pm Friday", kept on disk beside the segments it covers (.lbh).
+// A game can only be on a past board if it made the board when it was
+// played, so the file holds just those games in timestamp order, then a
+// checkpoint of the whole board every CHECKPOINT_EVERY of them, then this
+// footer. A point query loads the last checkpoint at or before the moment
+// and replays at most CHECKPOINT_EVERY records after it, so it costs
+// O(log n + DEPTH + CHECKPOINT_EVERY) and keeps nothing in memory but the
+// mapping. Little endian only.
+static constexpr char LBHIST_MAGIC[4] = {'L', 'B', 'H', 'S'};
+static constexpr uint32_t LBHIST_VERSION = 1;
+static constexpr size_t LBHIST_DEPTH = 100;
+
+struct HistoryCheckpoint
+{
+    int64_t timestamp; // of the last record replayed into it
+    uint64_t next;     // first record not replayed
+    uint32_t count;
+    uint32_t board[LBHIST_DEPTH]; // record numbers, best first
+    uint32_t reserved;
+};
+
+static_assert(sizeof(HistoryCheckpoint) == 424, "HistoryCheckpoint is part of the .lbh format");
+
+struct HistoryFooter
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;        // records
+    uint64_t checkpoints;
+    uint64_t coveredSeq;   // newest archived flush included
+    uint64_t coveredGames; // games in the archive it was built from
+};
+
+class LeaderboardHistory
+{
+public:
+    static constexpr size_t DEPTH = LBHIST_DEPTH; // places kept at every moment
+    static constexpr size_t CHECKPOINT_EVERY = 256;
+
+private:
+    MappedFile file;
+    HistoryFooter footer;
+    const SegmentRecord *records;
+    const HistoryCheckpoint *checkpoints;
+
+    // Replays next() until it returns false, in timestamp order, keeping the
+    // games that make the board; written beside filename and renamed once durable
+    static bool write(const string &filename, uint64_t coveredSeq, uint64_t coveredGames,
+                      const function<bool(LeaderboardEntry &)> &next);
+
+public:
+    LeaderboardHistory();
+
+    LeaderboardHistory(const LeaderboardHistory &) = delete;
+    LeaderboardHistory &operator=(const LeaderboardHistory &) = delete;
+
+    bool open(const string &filename); // false if missing or malformed; empty until then
+    bool covers(uint64_t seq, uint64_t games) const; // built from exactly this archive
+
+    // The board at timestamp over the covered games and unarchived ones
+    // (any order, later ones skipped), best first, at most DEPTH
+    vector<LeaderboardEntry> topAt(long long timestamp, size_t count, const vector<LeaderboardEntry> &unarchived) const;
+
+    // A new file at filename covering these games plus run, archived as flush seq
+    bool extend(const string &filename, uint64_t seq, uint64_t games, const vector<LeaderboardEntry> &run) const;
+    // A new file at filename from every game in the archive
+    static bool build(const string &filename, const vector<shared_ptr<const LeaderboardSegment>> &segments);
+};
+
+#endif
@@ -0,0 +1,676 @@
+#include "leaderboard_replicator.hpp"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include <set>
+#include <tuple>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+#define poll WSAPoll
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+using SocketHandle = int;
+static const SocketHandle NO_SOCKET = -1;
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+// Longest line a peer may send; leaderboard lines are far shorter
+static const size_t MAX_LINE = 64 * 1024;
+
+struct LeaderboardReplicator::Link
+{
+    SocketHandle socket = NO_SOCKET;
+    int address = -1;        // index into peerAddresses if we dialled it
+    bool connecting = false; // non-blocking connect still in progress
+    bool greeted = false;    // the peer's HELLO arrived
+    map<string, uint64_t> known; // games the peer holds, as far as we know
+    string inbox, outbox;
+
+    // GAMES message being read
+    string batchOrigin;
+    uint64_t batchSeq = 0;
+    uint64_t batchLeft = 0;
+    vector<LeaderboardEntry> batch;
+};
+
+static void closeSocket(SocketHandle socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static bool wouldBlock()
+{
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS;
+#endif
+}
+
+static bool prepareSocket(SocketHandle socket)
+{
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    return ioctlsocket(socket, FIONBIO, &nonBlocking) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static SocketHandle listenOn(int port)
+{
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == NO_SOCKET)
+        return NO_SOCKET;
+
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, 16) != 0 || !prepareSocket(listener))
+    {
+        closeSocket(listener);
+        return NO_SOCKET;
+    }
+    return listener;
+}
+
+// Starts a non-blocking connect to host:port
+static SocketHandle dial(const string &hostAndPort, bool &connecting)
+{
+    size_t colon = hostAndPort.rfind(':');
+    if (colon == string::npos)
+        return NO_SOCKET;
+    string host = hostAndPort.substr(0, colon);
+    string port = hostAndPort.substr(colon + 1);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *found = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0 || !found)
+        return NO_SOCKET;
+
+    SocketHandle peer = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (peer != NO_SOCKET && prepareSocket(peer))
+    {
+        connecting = connect(peer, found->ai_addr, (int)found->ai_addrlen) != 0;
+        if (connecting && !wouldBlock())
+        {
+            closeSocket(peer);
+            peer = NO_SOCKET;
+        }
+    }
+    else if (peer != NO_SOCKET)
+    {
+        closeSocket(peer);
+        peer = NO_SOCKET;
+    }
+    freeaddrinfo(found);
+    return peer;
+}
+
+static vector<string> splitFields(const string &line, char separator)
+{
+    vector<string> fields;
+    size_t start = 0, end;
+    while ((end = line.find(separator, start)) != string::npos)
+    {
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+static bool parseCount(const string &text, uint64_t &value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != string::npos)
+        return false;
+    value = strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+// Origins end up in HELLO and log lines, so their separators can't appear
+static bool validOrigin(const string &origin)
+{
+    return !origin.empty() && origin.find_first_of("|:,\n") == string::npos;
+}
+
+static string newInstanceId()
+{
+    random_device device;
+    uint64_t id = ((uint64_t)device() << 32) ^ device();
+    static const char digits[] = "0123456789abcdef";
+    string text(16, '0');
+    for (int i = 15; i >= 0; i--, id >>= 4)
+        text[i] = digits[id & 15];
+    return text;
+}
+
+LeaderboardReplicator::LeaderboardReplicator(Leaderboard &board)
+    : leaderboard(board), logSize(0), listenSocket((intptr_t)NO_SOCKET), running(false) {}
+
+LeaderboardReplicator::~LeaderboardReplicator()
+{
+    stop();
+}
+
+bool LeaderboardReplicator::start(int listenPort, const vector<string> &peers)
+{
+    stop();
+#ifdef _WIN32
+    WSADATA winsock;
+    if (WSAStartup(MAKEWORD(2, 2), &winsock) != 0)
+        return false;
+#endif
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!openLog())
+            return false;
+        restoreBoard();
+    }
+
+    SocketHandle listener = listenOn(listenPort);
+    if (listener == NO_SOCKET)
+    {
+        cerr << "Error: Unable to listen for leaderboard peers on port " << listenPort << endl;
+        lock_guard<mutex> lock(stateMutex);
+        log.close();
+        return false;
+    }
+    listenSocket = (intptr_t)listener;
+    peerAddresses = peers;
+    running = true;
+    worker = thread(&LeaderboardReplicator::run, this);
+    return true;
+}
+
+void LeaderboardReplicator::stop()
+{
+    running = false;
+    if (worker.joinable())
+    {
+        worker.join();
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+    lock_guard<mutex> lock(stateMutex);
+    log.close();
+}
+
+void LeaderboardReplicator::publish(const vector<LeaderboardEntry> &games)
+{
+    lock_guard<mutex> lock(stateMutex);
+    if (!log.isOpen())
+        return;
+    uint64_t version = versions[instanceId], size = logSize;
+    bool ok = true;
+    for (size_t i = 0; ok && i < games.size(); i++)
+        ok = appendGame(instanceId, games[i]);
+
+    // Durable before fillOutbox can see them: a seq a peer holds must never
+    // be lost here and handed out again for another game
+    if (!commitAppended(ok, instanceId, version, size))
+        cerr << "Error: Unable to sync " << logFilename << "; these games stay local" << endl;
+}
+
+bool LeaderboardReplicator::commitAppended(bool appended, const string &origin, uint64_t version, uint64_t size)
+{
+    if (appended && log.sync())
+        return true;
+    versions[origin] = version;
+    offsets[origin].resize(version);
+    logSize = size;
+    error_code ec;
+    filesystem::resize_file(logFilename, size, ec);
+    return false;
+}
+
+string LeaderboardReplicator::getInstanceId() const
+{
+    lock_guard<mutex> lock(stateMutex);
+    return instanceId;
+}
+
+map<string, uint64_t> LeaderboardReplicator::getVersions() const
+{
+    lock_guard<mutex> lock(stateMutex);
+    return versions;
+}
+
+// The log starts with "ID|<instance>", then one "<origin>|<seq>|<game>" line
+// per game held, each origin's seqs in order. A later ID line replaces the
+// instance; the games logged under the old one stay as another origin's.
+bool LeaderboardReplicator::openLog()
+{
+    instanceId.clear();
+    versions.clear();
+    offsets.clear();
+
+    uint64_t offset = 0, good = 0;
+    ifstream in(logFilename, ios::binary);
+    string line;
+    while (getline(in, line) && !in.eof()) // a last line without its newline is torn
+    {
+        uint64_t start = offset;
+        offset += line.size() + 1;
+        if (line.compare(0, 3, "ID|") == 0 && validOrigin(line.substr(3)))
+        {
+            instanceId = line.substr(3);
+            good = offset;
+            continue;
+        }
+        if (instanceId.empty())
+            break;
+
+        size_t first = line.find('|');
+        size_t second = first == string::npos ? string::npos : line.find('|', first + 1);
+        uint64_t seq;
+        LeaderboardEntry entry;
+        if (second == string::npos || !parseCount(line.substr(first + 1, second - first - 1), seq) ||
+            !Leaderboard::parseEntry(line.substr(second + 1), entry))
+            break;
+        string origin = line.substr(0, first);
+        if (!validOrigin(origin) || seq != versions[origin] + 1)
+            break;
+        versions[origin] = seq;
+        offsets[origin].push_back(start);
+        good = offset;
+    }
+    in.close();
+
+    // Anything after the last good line is cut off; peers send those games
+    // again. Games of this instance may have been among them, so it carries
+    // on under a new id rather than reuse their seqs.
+    error_code ec;
+    if (filesystem::exists(logFilename, ec) && filesystem::file_size(logFilename, ec) != good)
+    {
+        cerr << "Warning: Dropping a damaged tail of " << logFilename << endl;
+        filesystem::resize_file(logFilename, good, ec);
+        instanceId.clear();
+    }
+    logSize = good;
+
+    if (!log.open(logFilename))
+    {
+        cerr << "Error: Unable to open " << logFilename << endl;
+        return false;
+    }
+    if (instanceId.empty())
+    {
+        instanceId = newInstanceId();
+        string header = "ID|" + instanceId + "\n";
+        if (!log.append(header) || !log.sync())
+        {
+            cerr << "Error: Unable to write " << logFilename << endl;
+            log.close();
+            return false;
+        }
+        logSize += header.size();
+    }
+    return true;
+}
+
+bool LeaderboardReplicator::appendGame(const string &origin, const LeaderboardEntry &entry)
+{
+    uint64_t seq = versions[origin] + 1;
+    string line = origin + "|" + to_string(seq) + "|" + Leaderboard::formatEntry(entry) + "\n";
+    if (!log.append(line))
+    {
+        cerr << "Error: Unable to write " << logFilename << endl;
+        return false;
+    }
+    offsets[origin].push_back(logSize);
+    logSize += line.size();
+    versions[origin] = seq;
+    return true;
+}
+
+// Games are logged before they reach the board, so a crash in between
+// leaves the log holding games the board lacks, and versions tells peers
+// they are held. Compared per player, as a multiset: names and fields may
+// repeat across games, and segments cut long names.
+void LeaderboardReplicator::restoreBoard()
+{
+    unordered_map<string, vector<LeaderboardEntry>> logged;
+    ifstream in(logFilename, ios::binary);
+    string line;
+    while (getline(in, line))
+    {
+        size_t second = line.find('|', line.find('|') + 1);
+        LeaderboardEntry entry;
+        if (second != string::npos && Leaderboard::parseEntry(line.substr(second + 1), entry))
+            logged[entry.playerName].push_back(move(entry));
+    }
+    in.close();
+
+    auto fields = [](const LeaderboardEntry &entry)
+    { return make_tuple(entry.winnings, entry.level, entry.gamesPlayed, entry.timestamp); };
+    size_t restored = 0;
+    for (const auto &player : logged)
+    {
+        multiset<tuple<long long, int, int, long long>> onBoard;
+        for (const auto &entry : leaderboard.getPlayerHistory(player.first))
+            onBoard.insert(fields(entry));
+        for (const auto &entry : player.second)
+        {
+            auto found = onBoard.find(fields(entry));
+            if (found != onBoard.end())
+                onBoard.erase(found);
+            else
+            {
+                leaderboard.addEntry(entry);
+                restored++;
+            }
+        }
+    }
+    if (restored > 0)
+    {
+        cerr << "Warning: Restored " << restored << " games from " << logFilename << " missing from the leaderboard" << endl;
+        leaderboard.saveToFile();
+    }
+}
+
+vector<LeaderboardEntry> LeaderboardReplicator::readGames(const string &origin, uint64_t first, uint64_t count) const
+{
+    vector<LeaderboardEntry> games;
+    const vector<uint64_t> &positions = offsets.at(origin);
+    ifstream in(logFilename, ios::binary);
+    in.seekg((streamoff)positions[first - 1]);
+    string line;
+    while (games.size() < count && getline(in, line))
+    {
+        size_t second = line.find('|', line.find('|') + 1);
+        LeaderboardEntry entry;
+        if (second == string::npos || !Leaderboard::parseEntry(line.substr(second + 1), entry))
+            break;
+        // Other origins' games are interleaved in the log
+        if (line.compare(0, origin.size() + 1, origin + "|") == 0)
+            games.push_back(move(entry));
+    }
+    return games;
+}
+
+void LeaderboardReplicator::greet(Link &link) const
+{
+    lock_guard<mutex> lock(stateMutex);
+    string held;
+    for (const auto &version : versions)
+        held += (held.empty() ? "" : ",") + version.first + ":" + to_string(version.second);
+    link.outbox += "HELLO|" + instanceId + "|" + held + "\n";
+}
+
+// Queues what this instance holds and the peer doesn't, a batch at a time
+void LeaderboardReplicator::fillOutbox(Link &link) const
+{
+    if (!link.greeted || link.connecting)
+        return;
+    lock_guard<mutex> lock(stateMutex);
+    for (const auto &version : versions)
+    {
+        uint64_t &known = link.known[version.first];
+        while (known < version.second && link.outbox.size() < OUTBOX_LIMIT)
+        {
+            uint64_t count = min<uint64_t>(BATCH_SIZE, version.second - known);
+            vector<LeaderboardEntry> games = readGames(version.first, known + 1, count);
+            if (games.size() != count)
+            {
+                cerr << "Error: " << logFilename << " changed underneath the replicator" << endl;
+                return;
+            }
+            link.outbox += "GAMES|" + version.first + "|" + to_string(known + 1) + "|" + to_string(count) + "\n";
+            for (const auto &game : games)
+                link.outbox += Leaderboard::formatEntry(game) + "\n";
+            known += count;
+        }
+    }
+}
+
+bool LeaderboardReplicator::receive(Link &link)
+{
+    size_t start = 0, end;
+    while ((end = link.inbox.find('\n', start)) != string::npos)
+    {
+        if (!handleLine(link, link.inbox.substr(start, end - start)))
+            return false;
+        start = end + 1;
+    }
+    link.inbox.erase(0, start);
+    return link.inbox.size() <= MAX_LINE;
+}
+
+bool LeaderboardReplicator::handleLine(Link &link, const string &line)
+{
+    if (link.batchLeft > 0)
+    {
+        LeaderboardEntry entry;
+        if (!Leaderboard::parseEntry(line, entry))
+            return false;
+        link.batch.push_back(move(entry));
+        if (--link.batchLeft == 0)
+            applyBatch(link);
+        return true;
+    }
+
+    vector<string> fields = splitFields(line, '|');
+    if (fields[0] == "HELLO" && fields.size() == 3)
+    {
+        if (fields[1] == getInstanceId())
+            return false; // dialled ourselves
+        link.known.clear();
+        if (!fields[2].empty())
+        {
+            for (const string &version : splitFields(fields[2], ','))
+            {
+                size_t colon = version.find(':');
+                uint64_t count;
+                if (colon == string::npos || !validOrigin(version.substr(0, colon)) ||
+                    !parseCount(version.substr(colon + 1), count))
+                    return false;
+                link.known[version.substr(0, colon)] = count;
+            }
+        }
+        link.greeted = true;
+        return true;
+    }
+    if (fields[0] == "GAMES" && fields.size() == 4 && link.greeted)
+    {
+        link.batchOrigin = fields[1];
+        return validOrigin(link.batchOrigin) && parseCount(fields[2], link.batchSeq) && link.batchSeq > 0 &&
+               parseCount(fields[3], link.batchLeft) && link.batchLeft > 0 && link.batchLeft <= BATCH_SIZE;
+    }
+    return false;
+}
+
+// Keeps the games that extend what this instance holds of the origin; the
+// rest it has already (or will get in order later)
+void LeaderboardReplicator::applyBatch(Link &link)
+{
+    vector<LeaderboardEntry> accepted;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        uint64_t version = versions[link.batchOrigin], size = logSize;
+        bool ok = true;
+        for (size_t i = 0; ok && i < link.batch.size(); i++)
+        {
+            if (link.batchSeq + i != versions[link.batchOrigin] + 1)
+                continue;
+            ok = appendGame(link.batchOrigin, link.batch[i]);
+            if (ok)
+                accepted.push_back(link.batch[i]);
+        }
+        // Logged durably before the board saves them, so a crash can't leave
+        // games on the board that the peer would send again
+        if ((!ok || !accepted.empty()) && !commitAppended(ok, link.batchOrigin, version, size))
+        {
+            cerr << "Error: Unable to sync " << logFilename << endl;
+            accepted.clear();
+        }
+    }
+    uint64_t &known = link.known[link.batchOrigin];
+    known = max<uint64_t>(known, link.batchSeq + link.batch.size() - 1);
+    link.batch.clear();
+
+    for (const auto &game : accepted)
+        leaderboard.addEntry(game);
+    if (!accepted.empty())
+        leaderboard.saveToFile();
+}
+
+void LeaderboardReplicator::run()
+{
+    SocketHandle listener = (SocketHandle)listenSocket;
+    vector<Link> links;
+    vector<bool> linked(peerAddresses.size(), false);
+    vector<chrono::steady_clock::time_point> retryAt(peerAddresses.size());
+    char buffer[65536];
+
+    while (running)
+    {
+        auto now = chrono::steady_clock::now();
+        for (size_t i = 0; i < peerAddresses.size(); i++)
+        {
+            if (linked[i] || now < retryAt[i])
+                continue;
+            Link link;
+            link.socket = dial(peerAddresses[i], link.connecting);
+            if (link.socket == NO_SOCKET)
+            {
+                retryAt[i] = now + chrono::milliseconds(RETRY_MS);
+                continue;
+            }
+            link.address = (int)i;
+            if (!link.connecting)
+                greet(link);
+            linked[i] = true;
+            links.push_back(move(link));
+        }
+
+        vector<pollfd> polled(1 + links.size());
+        polled[0] = {listener, POLLIN, 0};
+        for (size_t i = 0; i < links.size(); i++)
+        {
+            fillOutbox(links[i]);
+            short events = POLLIN;
+            if (links[i].connecting || !links[i].outbox.empty())
+                events |= POLLOUT;
+            polled[i + 1] = {links[i].socket, events, 0};
+        }
+        if (poll(polled.data(), (unsigned long)polled.size(), POLL_MS) < 0)
+            continue;
+
+        for (size_t i = 0; i < links.size(); i++)
+        {
+            Link &link = links[i];
+            short events = polled[i + 1].revents;
+            bool open = true;
+            if (link.connecting && (events & (POLLOUT | POLLERR | POLLHUP)))
+            {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(link.socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length);
+                link.connecting = false;
+                open = error == 0;
+                if (open)
+                    greet(link);
+            }
+            else if (events & (POLLIN | POLLERR | POLLHUP))
+            {
+                while (open)
+                {
+                    int received = (int)recv(link.socket, buffer, sizeof(buffer), 0);
+                    if (received > 0)
+                        link.inbox.append(buffer, received);
+                    else
+                    {
+                        open = received < 0 && wouldBlock();
+                        break;
+                    }
+                }
+                open = receive(link) && open;
+            }
+
+            while (open && !link.connecting && !link.outbox.empty())
+            {
+                int sent = (int)send(link.socket, link.outbox.data(), (int)link.outbox.size(), MSG_NOSIGNAL);
+                if (sent <= 0)
+                {
+                    open = sent < 0 && wouldBlock();
+                    break;
+                }
+                link.outbox.erase(0, sent);
+            }
+
+            if (!open)
+            {
+                closeSocket(link.socket);
+                link.socket = NO_SOCKET;
+                if (link.address >= 0)
+                {
+                    linked[link.address] = false;
+                    retryAt[link.address] = now + chrono::milliseconds(RETRY_MS);
+                }
+            }
+        }
+        links.erase(remove_if(links.begin(), links.end(), [](const Link &link)
+                              { return link.socket == NO_SOCKET; }),
+                    links.end());
+
+        if (polled[0].revents & POLLIN)
+        {
+            SocketHandle accepted;
+            while ((accepted = accept(listener, nullptr, nullptr)) != NO_SOCKET)
+            {
+                Link link;
+                link.socket = accepted;
+                if (!prepareSocket(accepted))
+                {
+                    closeSocket(accepted);
+                    continue;
+                }
+                greet(link);
+                links.push_back(move(link));
+            }
+        }
+    }
+
+    // Whatever a peer missed goes out on the next connect
+    for (Link &link : links)
+        closeSocket(link.socket);
+    closeSocket(listener);
+    listenSocket = (intptr_t)NO_SOCKET;
+}
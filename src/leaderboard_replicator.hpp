@@ -0,0 +1,92 @@
+#ifndef LEADERBOARD_REPLICATOR_HPP
+#define LEADERBOARD_REPLICATOR_HPP
+
+#include "leaderboard.hpp"
+#include "append_file.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Shares one leaderboard between game instances on a LAN, without a server.
+//
+// Every game gets an id (origin instance, seq), seqs counting up from 1 per
+// origin. The replicated state is the set of those games and merging is set
+// union, so applying a batch twice or in any order across peers changes
+// nothing. Each instance holds a gap-free prefix of every origin's games, so
+// a version vector (origin -> games held) describes its whole state: peers
+// swap vectors on connect and then send each other only the difference, and
+// keep doing so as new games arrive.
+//
+// Wire protocol, one text line per message over TCP:
+//   HELLO|<instance>|<origin>:<count>,...
+//   GAMES|<origin>|<first seq>|<count>   followed by count leaderboard lines
+class LeaderboardReplicator
+{
+private:
+    static constexpr size_t BATCH_SIZE = 256;       // games per GAMES message
+    static constexpr size_t OUTBOX_LIMIT = 1 << 20; // bytes queued per peer before waiting on it
+    static constexpr int POLL_MS = 100;
+    static constexpr int RETRY_MS = 2000;
+
+    Leaderboard &leaderboard;
+    const string logFilename = "docs/replication.log";
+
+    // Everything below is guarded by stateMutex
+    mutable mutex stateMutex;
+    string instanceId;
+    map<string, uint64_t> versions;        // origin -> games held
+    map<string, vector<uint64_t>> offsets; // origin -> log offset of each game, by seq
+    AppendFile log;
+    uint64_t logSize;
+
+    struct Link; // one TCP connection, only touched by the network thread
+
+    intptr_t listenSocket;        // SOCKET on Windows, fd elsewhere
+    vector<string> peerAddresses; // host:port, dialled and redialled
+    atomic<bool> running;
+    thread worker;
+
+    bool openLog();
+    bool appendGame(const string &origin, const LeaderboardEntry &entry); // as the next seq of origin
+    // Syncs what was appended for origin since it held version games and the
+    // log was size bytes; otherwise undoes it. False if undone.
+    bool commitAppended(bool appended, const string &origin, uint64_t version, uint64_t size);
+    void restoreBoard(); // adds logged games missing from the leaderboard
+    vector<LeaderboardEntry> readGames(const string &origin, uint64_t first, uint64_t count) const;
+
+    void run();
+    void greet(Link &link) const;
+    void fillOutbox(Link &link) const;
+    bool receive(Link &link); // false if the peer broke the protocol
+    bool handleLine(Link &link, const string &line);
+    void applyBatch(Link &link);
+
+public:
+    LeaderboardReplicator(Leaderboard &board);
+    ~LeaderboardReplicator();
+
+    LeaderboardReplicator(const LeaderboardReplicator &) = delete;
+    LeaderboardReplicator &operator=(const LeaderboardReplicator &) = delete;
+
+    // Listens on listenPort and keeps a link to each host:port in peers
+    bool start(int listenPort, const vector<string> &peers);
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Games finished here, logged durably before it returns and sent to
+    // peers from the network thread. Call it before adding them to the
+    // leaderboard: start() restores logged games a crash kept off the board.
+    // Does nothing unless started.
+    void publish(const vector<LeaderboardEntry> &games);
+
+    string getInstanceId() const;
+    map<string, uint64_t> getVersions() const;
+};
+
+#endif
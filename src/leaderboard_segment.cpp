@@ -0,0 +1,175 @@
+#include "leaderboard_segment.hpp"
+#include "append_file.hpp"
+#include <filesystem>
+#include <numeric>
+#include <cstring>
+
+using namespace std;
+
+static bool recordBefore(const SegmentRecord &record, const LeaderboardEntry &entry)
+{
+    if (record.winnings != entry.winnings)
+        return record.winnings > entry.winnings;
+    return record.level > entry.level;
+}
+
+static string recordName(const SegmentRecord &record)
+{
+    return string(record.playerName, strnlen(record.playerName, LBSEG_NAME_BYTES));
+}
+
+static int compareName(const SegmentRecord &record, const string &name)
+{
+    size_t length = strnlen(record.playerName, LBSEG_NAME_BYTES);
+    int order = memcmp(record.playerName, name.data(), min(length, name.size()));
+    if (order != 0)
+        return order;
+    return length < name.size() ? -1 : (length > name.size() ? 1 : 0);
+}
+
+LeaderboardSegment::LeaderboardSegment() : footer(), records(nullptr), nameIndex(nullptr) {}
+
+bool LeaderboardSegment::open(const string &filename)
+{
+    path = filename;
+    if (!file.open(filename) || file.size() < sizeof(SegmentFooter))
+        return false;
+
+    memcpy(&footer, file.data() + file.size() - sizeof(SegmentFooter), sizeof(SegmentFooter));
+    if (memcmp(footer.magic, LBSEG_MAGIC, sizeof(LBSEG_MAGIC)) != 0 || footer.version != LBSEG_VERSION)
+        return false;
+    uint64_t expected = footer.count * (sizeof(SegmentRecord) + sizeof(uint32_t)) + sizeof(SegmentFooter);
+    if (footer.count > file.size() || expected != file.size())
+        return false;
+
+    records = reinterpret_cast<const SegmentRecord *>(file.data());
+    nameIndex = reinterpret_cast<const uint32_t *>(file.data() + footer.count * sizeof(SegmentRecord));
+    return true;
+}
+
+SegmentRecord LeaderboardSegment::toRecord(const LeaderboardEntry &entry)
+{
+    SegmentRecord record = {};
+    record.winnings = entry.winnings;
+    record.timestamp = entry.timestamp;
+    record.level = entry.level;
+    record.gamesPlayed = entry.gamesPlayed;
+    memcpy(record.playerName, entry.playerName.data(), min(entry.playerName.size(), LBSEG_NAME_BYTES - 1));
+    return record;
+}
+
+LeaderboardEntry LeaderboardSegment::fromRecord(const SegmentRecord &record)
+{
+    return {recordName(record), record.winnings, record.level, record.gamesPlayed, record.timestamp};
+}
+
+LeaderboardEntry LeaderboardSegment::at(size_t position) const
+{
+    return fromRecord(records[position]);
+}
+
+size_t LeaderboardSegment::countBefore(const LeaderboardEntry &entry) const
+{
+    size_t low = 0, high = size();
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (recordBefore(records[middle], entry))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void LeaderboardSegment::findPlayer(const string &fullName, vector<LeaderboardEntry> &out) const
+{
+    string playerName = fullName.substr(0, LBSEG_NAME_BYTES - 1);
+    const uint32_t *first = lower_bound(nameIndex, nameIndex + size(), playerName,
+                                        [&](uint32_t position, const string &name)
+                                        { return compareName(records[position], name) < 0; });
+    for (const uint32_t *it = first; it != nameIndex + size() && compareName(records[*it], playerName) == 0; ++it)
+        out.push_back(at(*it));
+}
+
+void LeaderboardSegment::forEachPlayerBest(const function<void(size_t)> &visit) const
+{
+    for (size_t i = 0; i < size(); i++)
+    {
+        const SegmentRecord &record = records[nameIndex[i]];
+        if (i == 0 || strncmp(records[nameIndex[i - 1]].playerName, record.playerName, LBSEG_NAME_BYTES) != 0)
+            visit(nameIndex[i]);
+    }
+}
+
+bool LeaderboardSegment::write(const string &filename, uint32_t level, uint64_t firstSeq, uint64_t lastSeq,
+                               const function<bool(LeaderboardEntry &)> &next)
+{
+    const string tempFile = filename + ".tmp";
+    error_code ec;
+    filesystem::remove(tempFile, ec);
+
+    SegmentFooter footer = {};
+    memcpy(footer.magic, LBSEG_MAGIC, sizeof(LBSEG_MAGIC));
+    footer.version = LBSEG_VERSION;
+    footer.firstSeq = firstSeq;
+    footer.lastSeq = lastSeq;
+    footer.level = level;
+
+    // Records are streamed out in 64 KB chunks, so merging never holds a run in memory
+    AppendFile out;
+    bool written = out.open(tempFile);
+    string chunk;
+    LeaderboardEntry entry;
+    while (written && next(entry))
+    {
+        SegmentRecord record = toRecord(entry);
+        chunk.append(reinterpret_cast<const char *>(&record), sizeof(record));
+
+        footer.count++;
+        footer.totalPrizePool += entry.winnings;
+        footer.levelSum += entry.level;
+        footer.maxTimestamp = max(footer.maxTimestamp, (int64_t)entry.timestamp);
+        footer.levelHistogram[min(max(entry.level, 0), LEADERBOARD_MAX_LEVEL)]++;
+
+        if (chunk.size() >= 65536)
+        {
+            written = out.append(chunk);
+            chunk.clear();
+        }
+    }
+    written = written && out.append(chunk);
+    out.close();
+
+    // The name index needs every name, so it is sorted from the written records
+    if (written)
+    {
+        MappedFile recordsFile;
+        written = recordsFile.open(tempFile) && recordsFile.size() == footer.count * sizeof(SegmentRecord);
+        if (written)
+        {
+            const SegmentRecord *records = reinterpret_cast<const SegmentRecord *>(recordsFile.data());
+            vector<uint32_t> index(footer.count);
+            iota(index.begin(), index.end(), 0u);
+            stable_sort(index.begin(), index.end(), [&](uint32_t a, uint32_t b)
+                        { return strncmp(records[a].playerName, records[b].playerName, LBSEG_NAME_BYTES) < 0; });
+            recordsFile.close();
+
+            written = out.open(tempFile) &&
+                      out.append(string_view(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(uint32_t))) &&
+                      out.append(string_view(reinterpret_cast<const char *>(&footer), sizeof(footer))) &&
+                      out.sync();
+            out.close();
+        }
+    }
+
+    if (written)
+        filesystem::rename(tempFile, filename, ec);
+    if (!written || ec)
+    {
+        cerr << "Error: Unable to write leaderboard segment " << filename << endl;
+        filesystem::remove(tempFile, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef LEADERBOARD_SEGMENT_HPP
+#define LEADERBOARD_SEGMENT_HPP
+
+#include "leaderboard.hpp"
+#include "mapped_file.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// Immutable run of archived games on disk (.lbs): count fixed-width records
+// sorted best first, then count uint32 record positions sorted by player
+// name, then this footer. Little endian only.
+static constexpr char LBSEG_MAGIC[4] = {'L', 'B', 'S', 'G'};
+static constexpr uint32_t LBSEG_VERSION = 1;
+static constexpr size_t LBSEG_NAME_BYTES = 24; // names are cut to 23 bytes
+
+struct SegmentRecord
+{
+    int64_t winnings;
+    int64_t timestamp;
+    int32_t level;
+    int32_t gamesPlayed;
+    char playerName[LBSEG_NAME_BYTES]; // NUL padded
+};
+
+static_assert(sizeof(SegmentRecord) == 48, "SegmentRecord is part of the .lbs format");
+
+struct SegmentFooter
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t firstSeq; // flushes this segment covers, oldest to newest
+    uint64_t lastSeq;
+    uint32_t level;    // 0 = one flush, n = FANIN^n flushes merged
+    uint32_t reserved;
+    int64_t totalPrizePool;
+    int64_t levelSum;
+    int64_t maxTimestamp;
+    uint64_t levelHistogram[LEADERBOARD_MAX_LEVEL + 1];
+};
+
+class LeaderboardSegment
+{
+private:
+    MappedFile file;
+    string path;
+    SegmentFooter footer;
+    const SegmentRecord *records;
+    const uint32_t *nameIndex;
+
+public:
+    LeaderboardSegment();
+
+    LeaderboardSegment(const LeaderboardSegment &) = delete;
+    LeaderboardSegment &operator=(const LeaderboardSegment &) = delete;
+
+    bool open(const string &filename); // false if missing or malformed
+    const string &getPath() const { return path; }
+    const SegmentFooter &getFooter() const { return footer; }
+    size_t size() const { return (size_t)footer.count; }
+
+    static SegmentRecord toRecord(const LeaderboardEntry &entry); // name cut to fit
+    static LeaderboardEntry fromRecord(const SegmentRecord &record);
+
+    LeaderboardEntry at(size_t position) const;
+    size_t countBefore(const LeaderboardEntry &entry) const; // records strictly before entry
+    void findPlayer(const string &playerName, vector<LeaderboardEntry> &out) const; // best first
+    // Calls visit(position) for each player's first (best) record
+    void forEachPlayerBest(const function<void(size_t)> &visit) const;
+
+    // Streams next() until it returns false into a new segment at filename,
+    // written beside it and renamed once durable. Entries must come sorted.
+    static bool write(const string &filename, uint32_t level, uint64_t firstSeq, uint64_t lastSeq,
+                      const function<bool(LeaderboardEntry &)> &next);
+};
+
+#endif
@@ -1,4 +1,9 @@
 #include <iostream>
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <cerrno>
 #include "game_controller.hpp"
 #include "game_engine.hpp"
 #include "game_state.hpp"
@@ -6,16 +11,90 @@
 
 using namespace std;
 
-int main(int, char **)
+// "2026-10-16 18:00" in local time, or unix seconds; -1 if neither
+static long long parseMoment(const string &text)
+{
+    if (!text.empty() && text.find_first_not_of("0123456789") == string::npos)
+    {
+        errno = 0;
+        long long seconds = strtoll(text.c_str(), nullptr, 10);
+        return errno == ERANGE ? -1 : seconds;
+    }
+    tm moment = {};
+    istringstream in(text);
+    in >> get_time(&moment, "%Y-%m-%d %H:%M");
+    if (in.fail())
+        return -1;
+    moment.tm_isdst = -1;
+    return (long long)mktime(&moment);
+}
+
+// The all-time board as the kiosk showed it at a past moment, for disputes
+static int printBoardAt(Leaderboard &leaderboard, const string &when)
+{
+    long long moment = parseMoment(when);
+    if (moment < 0)
+    {
+        cerr << "Expected --board-at \"YYYY-MM-DD HH:MM\" (local time) or unix seconds.\n";
+        return 1;
+    }
+    vector<LeaderboardEntry> top = leaderboard.getTopAt(moment, (int)Leaderboard::SNAPSHOT_SIZE);
+    cout << "Leaderboard at " << when << ":\n";
+    for (size_t i = 0; i < top.size(); i++)
+    {
+        time_t played = (time_t)top[i].timestamp;
+        cout << setw(3) << i + 1 << ". " << left << setw(20) << top[i].playerName << right
+             << setw(10) << top[i].winnings << "  level " << setw(2) << top[i].level << "  ";
+        if (top[i].timestamp > 0)
+            cout << put_time(localtime(&played), "%Y-%m-%d %H:%M") << "\n";
+        else
+            cout << "(undated)\n";
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
 {
    
     GameEngine engine;
 
-    if (!engine.initialize("docs/questions.txt"))
+    const string questionsFile = "docs/questions.txt";
+
+    // --paged <MB>: keep only the question index resident and page text
+    // through a cache of that size (for banks larger than RAM)
+    size_t pageCacheBytes = 0;
+    // --replicate <port> [--peer <host:port>]...: share the leaderboard with
+    // other instances on the LAN
+    int replicationPort = 0;
+    vector<string> peers;
+    string boardAt; // --board-at <time>: print the board as it stood then and exit
+    string gameMode = "classic"; // --mode <name>: a category mix from docs/game_modes.txt
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (string(argv[i]) == "--paged")
+            pageCacheBytes = (size_t)max(1L, strtol(argv[i + 1], nullptr, 10)) << 20;
+        else if (string(argv[i]) == "--replicate")
+            replicationPort = (int)strtol(argv[i + 1], nullptr, 10);
+        else if (string(argv[i]) == "--peer")
+            peers.push_back(argv[i + 1]);
+        else if (string(argv[i]) == "--board-at")
+            boardAt = argv[i + 1];
+        else if (string(argv[i]) == "--mode")
+            gameMode = argv[i + 1];
+    }
+    if (!boardAt.empty())
+        return printBoardAt(engine.getLeaderboard(), boardAt);
+
+    // Loads docs/questions.qpack instead while it is current, and reloads
+    // whenever questions.txt is edited
+    if (!engine.initialize(questionsFile, pageCacheBytes))
     {
         cerr << "Failed to load questions. Make sure 'docs/questions.txt' exists.\n";
         return 1;
     }
+    engine.setGameMode(gameMode);
+    if (replicationPort > 0 && !engine.startReplication(replicationPort, peers))
+        cerr << "Leaderboard replication is off; playing with this kiosk's board only.\n";
 
     GameController controller(engine);
 
@@ -41,6 +120,9 @@ int main(int, char **)
     CloseAudioDevice();
     CloseWindow();
 
+    // Finished games are saved in the background; wait for the last ones
+    engine.shutdown();
+
     cout << "Goodbye!\n\n";
 
     return 0;
@@ -0,0 +1,110 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Empty files cannot be mapped; they are reported as open with size 0.
+static const char EMPTY_MAPPING[1] = {'\0'};
+
+MappedFile::MappedFile() : mappedData(nullptr), mappedSize(0) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string &filename)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    if (fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        mappedData = EMPTY_MAPPING;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view)
+        return false;
+
+    mappedData = static_cast<const char *>(view);
+    mappedSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (info.st_size == 0)
+    {
+        ::close(fd);
+        mappedData = EMPTY_MAPPING;
+        return true;
+    }
+
+    void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    mappedData = static_cast<const char *>(view);
+    mappedSize = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mappedData && mappedData != EMPTY_MAPPING)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mappedData);
+#else
+        munmap(const_cast<char *>(mappedData), mappedSize);
+#endif
+    }
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
+bool MappedFile::isOpen() const { return mappedData != nullptr; }
+
+const char *MappedFile::data() const { return mappedData; }
+
+size_t MappedFile::size() const { return mappedSize; }
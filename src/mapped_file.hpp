@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// Read-only memory mapping of a whole file. The OS handles are released right
+// after mapping; only the view is kept until close() or destruction.
+class MappedFile
+{
+private:
+    const char *mappedData;
+    size_t mappedSize;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const string &filename);
+    void close();
+
+    bool isOpen() const;
+    const char *data() const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef MERGE_SORT_HPP
+#define MERGE_SORT_HPP
+
+#include "parallel.hpp"
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+using namespace std;
+
+// Stable bottom-up merge sort by operator<. Elements are moved, never copied,
+// between the vector and one scratch buffer of the same size. Each pass is
+// cut into roughly equal slices of output (merge path), so the last passes
+// keep every thread busy too. threads = 0 uses every core.
+template <typename T>
+class MergeSorter
+{
+private:
+    static constexpr size_t RUN = 32;           // insertion sorted before merging
+    static constexpr size_t GRAIN = 1 << 14;    // output elements per task
+    static constexpr size_t PARALLEL_MIN = 1 << 15;
+
+    struct Slice
+    {
+        size_t lo, mid, hi;       // merging [lo, mid) with [mid, hi)
+        size_t outBegin, outEnd;  // relative to lo
+    };
+
+    static void insertionSort(T *first, T *last)
+    {
+        for (T *i = first + 1; i < last; i++)
+        {
+            if (!(*i < *(i - 1)))
+                continue;
+            T value = move(*i);
+            T *j = i;
+            for (; j > first && value < *(j - 1); j--)
+                *j = move(*(j - 1));
+            *j = move(value);
+        }
+    }
+
+    // Number of elements from a that land in the first k outputs; ties go to a
+    static size_t coRank(const T *a, size_t aSize, const T *b, size_t bSize, size_t k)
+    {
+        size_t lo = k > bSize ? k - bSize : 0;
+        size_t hi = min(k, aSize);
+        while (lo < hi)
+        {
+            size_t i = lo + (hi - lo) / 2;
+            size_t j = k - i;
+            if (j > 0 && !(b[j - 1] < a[i]))
+                lo = i + 1;
+            else
+                hi = i;
+        }
+        return lo;
+    }
+
+    static void mergeSlice(T *src, T *dst, const Slice &slice)
+    {
+        const T *a = src + slice.lo;
+        const T *b = src + slice.mid;
+        size_t aSize = slice.mid - slice.lo;
+        size_t bSize = slice.hi - slice.mid;
+
+        size_t i = coRank(a, aSize, b, bSize, slice.outBegin);
+        size_t iEnd = coRank(a, aSize, b, bSize, slice.outEnd);
+        size_t j = slice.outBegin - i;
+        size_t jEnd = slice.outEnd - iEnd;
+
+        T *out = dst + slice.lo + slice.outBegin;
+        while (i < iEnd && j < jEnd)
+        {
+            if (src[slice.mid + j] < src[slice.lo + i])
+                *out++ = move(src[slice.mid + j++]);
+            else
+                *out++ = move(src[slice.lo + i++]);
+        }
+        while (i < iEnd)
+            *out++ = move(src[slice.lo + i++]);
+        while (j < jEnd)
+            *out++ = move(src[slice.mid + j++]);
+    }
+
+public:
+    static void sort(vector<T> &items, unsigned threads = 0)
+    {
+        size_t n = items.size();
+        if (n < 2)
+            return;
+        if (n < PARALLEL_MIN)
+            threads = 1;
+
+        size_t runCount = (n + RUN - 1) / RUN;
+        parallelFor(runCount, threads, [&](size_t r)
+                    {
+                        T *first = items.data() + r * RUN;
+                        insertionSort(first, first + min(RUN, n - r * RUN)); });
+        if (n <= RUN)
+            return;
+
+        vector<T> buffer(n);
+        T *src = items.data();
+        T *dst = buffer.data();
+        vector<Slice> slices;
+
+        for (size_t width = RUN; width < n; width *= 2)
+        {
+            slices.clear();
+            for (size_t lo = 0; lo < n; lo += 2 * width)
+            {
+                size_t mid = min(lo + width, n);
+                size_t hi = min(lo + 2 * width, n);
+                for (size_t out = 0; out < hi - lo; out += GRAIN)
+                    slices.push_back({lo, mid, hi, out, min(out + GRAIN, hi - lo)});
+            }
+
+            parallelFor(slices.size(), threads, [&](size_t s)
+                        { mergeSlice(src, dst, slices[s]); });
+            swap(src, dst);
+        }
+
+        if (src != items.data())
+            items.swap(buffer);
+    }
+};
+
+#endif
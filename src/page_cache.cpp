@@ -0,0 +1,70 @@
+#include "page_cache.hpp"
+
+using namespace std;
+
+PageCache::PageCache(size_t budget) : budgetBytes(budget), usedBytes(0), hits(0), misses(0) {}
+
+void PageCache::setBudget(size_t bytes)
+{
+    budgetBytes = bytes;
+    evictToBudget();
+}
+
+shared_ptr<const vector<char>> PageCache::find(size_t key)
+{
+    auto it = lookup.find(key);
+    if (it == lookup.end())
+    {
+        misses++;
+        return nullptr;
+    }
+
+    hits++;
+    pages.splice(pages.begin(), pages, it->second);
+    return it->second->data;
+}
+
+shared_ptr<const vector<char>> PageCache::insert(size_t key, vector<char> &&data)
+{
+    auto it = lookup.find(key);
+    if (it != lookup.end())
+    {
+        usedBytes -= it->second->data->size() + PAGE_OVERHEAD;
+        pages.erase(it->second);
+        lookup.erase(it);
+    }
+
+    usedBytes += data.size() + PAGE_OVERHEAD;
+    shared_ptr<const vector<char>> page = make_shared<const vector<char>>(move(data));
+    pages.push_front(Page{key, page});
+    lookup[key] = pages.begin();
+    evictToBudget();
+    return page;
+}
+
+void PageCache::evictToBudget()
+{
+    // The newest page always stays, even when it alone exceeds the budget
+    while (usedBytes > budgetBytes && pages.size() > 1)
+    {
+        Page &oldest = pages.back();
+        usedBytes -= oldest.data->size() + PAGE_OVERHEAD;
+        lookup.erase(oldest.key);
+        pages.pop_back();
+    }
+}
+
+void PageCache::clear()
+{
+    pages.clear();
+    lookup.clear();
+    usedBytes = 0;
+}
+
+size_t PageCache::getBudget() const { return budgetBytes; }
+
+size_t PageCache::getUsedBytes() const { return usedBytes; }
+
+size_t PageCache::getHits() const { return hits; }
+
+size_t PageCache::getMisses() const { return misses; }
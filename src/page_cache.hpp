@@ -0,0 +1,50 @@
+#ifndef PAGE_CACHE_HPP
+#define PAGE_CACHE_HPP
+
+#include <list>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+using namespace std;
+
+// Least-recently-used cache of byte pages under a memory budget. Pages are
+// shared, so one handed out stays valid after eviction. Not synchronized;
+// the owner serializes access.
+class PageCache
+{
+private:
+    struct Page
+    {
+        size_t key;
+        shared_ptr<const vector<char>> data;
+    };
+
+    // Rough cost of a page beyond its bytes: list node, map node, vector header
+    static constexpr size_t PAGE_OVERHEAD = 96;
+
+    size_t budgetBytes;
+    size_t usedBytes;
+    list<Page> pages; // most recently used first
+    unordered_map<size_t, list<Page>::iterator> lookup;
+    size_t hits;
+    size_t misses;
+
+    void evictToBudget();
+
+public:
+    PageCache(size_t budget = 4 << 20);
+
+    void setBudget(size_t bytes);
+    shared_ptr<const vector<char>> find(size_t key);                   // nullptr on a miss
+    shared_ptr<const vector<char>> insert(size_t key, vector<char> &&data); // evicts older pages past the budget
+    void clear();
+
+    size_t getBudget() const;
+    size_t getUsedBytes() const;
+    size_t getHits() const;
+    size_t getMisses() const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+// 0 means one thread per hardware core
+inline unsigned resolveThreadCount(unsigned requested)
+{
+    if (requested > 0)
+        return requested;
+    return max(1u, thread::hardware_concurrency());
+}
+
+// Runs task(0) .. task(taskCount - 1) on a fixed pool of worker threads that
+// pull task numbers from a shared counter. The caller's thread is one of the
+// workers, so a single thread never spawns anything.
+inline void parallelFor(size_t taskCount, unsigned threads, const function<void(size_t)> &task)
+{
+    atomic<size_t> nextTask(0);
+    auto worker = [&]()
+    {
+        for (size_t i = nextTask++; i < taskCount; i = nextTask++)
+            task(i);
+    };
+
+    unsigned workerCount = (unsigned)min<size_t>(resolveThreadCount(threads), taskCount);
+    vector<thread> pool;
+    for (unsigned i = 1; i < workerCount; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (thread &t : pool)
+        t.join();
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "persistence_worker.hpp"
+#include <chrono>
+#include <ctime>
+
+using namespace std;
+
+PersistenceWorker::PersistenceWorker(Leaderboard &board, PlayerProfileManager &profileManager,
+                                     LeaderboardReplicator &boardReplicator)
+    : leaderboard(board), profiles(profileManager), replicator(boardReplicator), queue(QUEUE_CAPACITY), running(true)
+{
+    worker = thread(&PersistenceWorker::run, this);
+}
+
+PersistenceWorker::~PersistenceWorker()
+{
+    flush();
+}
+
+void PersistenceWorker::submit(FinishedGame &&result)
+{
+    if (!queue.tryPush(move(result)))
+    {
+        // Hundreds of games behind: write this one here rather than drop it
+        cerr << "Warning: persistence queue full, saving on the game thread" << endl;
+        drain();
+        LeaderboardEntry entry = {result.name, result.winnings, result.level, result.questionsAnswered, result.timestamp};
+        replicator.publish({entry});
+        leaderboard.addEntry(entry);
+        leaderboard.recordAnswers(result.answers);
+        profiles.updatePlayerStats(result.name, result.winnings, result.level, result.questionsAnswered);
+        SeenHistory::appendRecorded(result.seenFile, result.seenQuestions);
+        leaderboard.saveToFile();
+        profiles.saveProfiles();
+        return;
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::flush()
+{
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        running = false;
+    }
+    wake.notify_one();
+    if (worker.joinable())
+        worker.join();
+    drain();
+}
+
+void PersistenceWorker::run()
+{
+    while (running)
+    {
+        {
+            // A push between the drain and this wait is caught by the timeout
+            unique_lock<mutex> lock(wakeMutex);
+            wake.wait_for(lock, chrono::milliseconds(IDLE_FLUSH_MS));
+        }
+        drain();
+    }
+}
+
+void PersistenceWorker::drain()
+{
+    // The day moves on first, so games played since midnight count for today
+    leaderboard.rollWindows((long long)time(nullptr));
+    vector<FinishedGame> results;
+    vector<LeaderboardEntry> games;
+    FinishedGame result;
+    while (queue.tryPop(result))
+    {
+        games.push_back({result.name, result.winnings, result.level, result.questionsAnswered, result.timestamp});
+        results.push_back(move(result));
+    }
+
+    // Logged for replication first; the replicator restores any a crash
+    // keeps off the board
+    if (!games.empty())
+        replicator.publish(games);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        leaderboard.addEntry(games[i]);
+        leaderboard.recordAnswers(results[i].answers);
+        profiles.updatePlayerStats(results[i].name, results[i].winnings, results[i].level, results[i].questionsAnswered);
+        SeenHistory::appendRecorded(results[i].seenFile, results[i].seenQuestions);
+    }
+
+    if (!games.empty())
+        leaderboard.saveToFile();
+    profiles.saveProfiles(); // also picks up profiles created at game setup
+}
@@ -0,0 +1,67 @@
+#ifndef PERSISTENCE_WORKER_HPP
+#define PERSISTENCE_WORKER_HPP
+
+#include "bounded_queue.hpp"
+#include "leaderboard.hpp"
+#include "leaderboard_replicator.hpp"
+#include "player_profile.hpp"
+#include "seen_history.hpp"
+#include <string>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Outcome of one finished game, as handed from the frame loop to the worker
+struct FinishedGame
+{
+    string name;
+    long long winnings;
+    int level;
+    int questionsAnswered;
+    long long timestamp; // unix seconds
+    vector<pair<int, bool>> answers; // (category, correct) per question
+    string seenFile;                 // the player's seen-question history
+    vector<int32_t> seenQuestions;   // first asked this game, appended to seenFile
+};
+
+// Applies finished games to the leaderboard and profiles on a background
+// thread, so the frame loop never waits on file I/O. Everything queued since
+// the last pass is written together: one leaderboard save and one fsynced
+// profile batch, however many games finished meanwhile, plus each game's
+// seen-question append. Games are handed to the replicator for other
+// instances before they are saved here.
+class PersistenceWorker
+{
+private:
+    static constexpr size_t QUEUE_CAPACITY = 256;
+    static constexpr int IDLE_FLUSH_MS = 1000; // profile changes made outside games, leaderboard day rollover
+
+    Leaderboard &leaderboard;
+    PlayerProfileManager &profiles;
+    LeaderboardReplicator &replicator;
+    BoundedQueue<FinishedGame> queue;
+    atomic<bool> running;
+    mutex wakeMutex;
+    condition_variable wake;
+    thread worker;
+
+    void run();
+    void drain(); // applies and persists everything queued
+
+public:
+    PersistenceWorker(Leaderboard &board, PlayerProfileManager &profileManager, LeaderboardReplicator &boardReplicator);
+    ~PersistenceWorker();
+
+    PersistenceWorker(const PersistenceWorker &) = delete;
+    PersistenceWorker &operator=(const PersistenceWorker &) = delete;
+
+    void submit(FinishedGame &&result); // never blocks unless the queue is full
+    void flush();                     // writes everything queued and stops the worker
+};
+
+#endif
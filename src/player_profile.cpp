@@ -1,26 +1,36 @@
 #include "player_profile.hpp"
-#include <vector>
+#include <filesystem>
+#include <charconv>
 
 using namespace std;
 
-PlayerProfileManager::PlayerProfileManager()
+PlayerProfileManager::PlayerProfileManager() : pendingRecords(0), journalRecords(0), compacting(false)
 {
     loadProfiles();
 }
 
+PlayerProfileManager::~PlayerProfileManager()
+{
+    saveProfiles();
+    if (compactor.joinable())
+        compactor.join();
+}
+
 PlayerStats PlayerProfileManager::getOrCreateProfile(const string &name, const string &gender)
 {
+    lock_guard<mutex> lock(profilesMutex);
     if (profiles.find(name) == profiles.end())
     {
         profiles[name] = PlayerStats(name, gender);
-        // FIX: Save immediately so the file is populated right after setup
-        saveProfiles();
+        // Queued for the journal; written with the next saveProfiles batch
+        appendRecord(profiles[name]);
     }
     return profiles[name];
 }
 
 void PlayerProfileManager::updatePlayerStats(const string &name, long long winnings, int level, int questionsAnswered)
 {
+    lock_guard<mutex> lock(profilesMutex);
     if (profiles.find(name) != profiles.end())
     {
         profiles[name].gamesPlayed++;
@@ -29,63 +39,197 @@ void PlayerProfileManager::updatePlayerStats(const string &name, long long winni
         {
             profiles[name].maxLevel = level;
         }
-        saveProfiles(); // Saves progress updates
+        appendRecord(profiles[name]); // Saves progress updates
     }
 }
 
 bool PlayerProfileManager::playerExists(const string &name) const
 {
+    lock_guard<mutex> lock(profilesMutex);
     return profiles.find(name) != profiles.end();
 }
 
-void PlayerProfileManager::saveProfiles() const
+string PlayerProfileManager::formatProfile(const PlayerStats &stats)
+{
+    return stats.name + "|" + stats.gender + "|" + to_string(stats.gamesPlayed) + "|" +
+           to_string(stats.totalWinnings) + "|" + to_string(stats.maxLevel) + "\n";
+}
+
+bool PlayerProfileManager::parseProfile(const string &line, PlayerStats &stats)
+{
+    vector<string> tokens;
+    stringstream ss(line);
+    string token;
+
+    while (getline(ss, token, '|'))
+    {
+        tokens.push_back(token);
+    }
+
+    if (tokens.size() < 5)
+        return false;
+
+    stats = PlayerStats(tokens[0], tokens[1]);
+    auto parse = [](const string &field, auto &value)
+    {
+        auto result = from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == errc() && result.ptr == field.data() + field.size();
+    };
+    return parse(tokens[2], stats.gamesPlayed) && parse(tokens[3], stats.totalWinnings) &&
+           parse(tokens[4], stats.maxLevel);
+}
+
+void PlayerProfileManager::appendRecord(const PlayerStats &stats)
 {
-    ofstream file(filename);
-    if (file.is_open())
+    pendingJournal += formatProfile(stats);
+    pendingRecords++;
+}
+
+void PlayerProfileManager::saveProfiles()
+{
+    lock_guard<mutex> ioLock(journalMutex);
+
+    // Take the batch so the game thread can keep recording during the I/O
+    string batch;
+    size_t records, profileCount;
+    {
+        lock_guard<mutex> lock(profilesMutex);
+        batch.swap(pendingJournal);
+        records = pendingRecords;
+        pendingRecords = 0;
+        profileCount = profiles.size();
+    }
+    if (records == 0)
+        return;
+
+    if (!journal.append(batch) || !journal.sync())
+        cerr << "Error: Unable to save player profiles to " << journalFile << endl;
+    journalRecords += records;
+
+    if (journalRecords >= max(MIN_COMPACT_RECORDS, profileCount))
+        startCompaction();
+}
+
+void PlayerProfileManager::startCompaction()
+{
+    if (compacting)
+        return;
+    if (compactor.joinable())
+        compactor.join();
+
+    // Freeze the journal so the snapshot covers it; new records start a fresh
+    // one. A leftover frozen journal from a failed compaction is kept instead,
+    // since the new snapshot covers both.
+    error_code ec;
+    if (!filesystem::exists(compactingFile, ec))
+    {
+        journal.close();
+        filesystem::rename(journalFile, compactingFile, ec);
+        if (!journal.open(journalFile))
+            cerr << "Error: Unable to open " << journalFile << endl;
+    }
+    journalRecords = 0;
+
+    // Copying is O(profiles) but happens once per O(profiles) records
+    vector<PlayerStats> snapshot;
     {
+        lock_guard<mutex> lock(profilesMutex);
+        snapshot.reserve(profiles.size());
         for (const auto &entry : profiles)
-        {
-            file << entry.first << "|" << entry.second.gender << "|"
-                 << entry.second.gamesPlayed << "|" << entry.second.totalWinnings << "|"
-                 << entry.second.maxLevel << "\n";
-        }
-        file.close();
+            snapshot.push_back(entry.second);
     }
-    else
+
+    compacting = true;
+    compactor = thread([this, snapshot = move(snapshot)]()
+                       {
+                           error_code removeError;
+                           if (writeSnapshot(snapshot))
+                               filesystem::remove(compactingFile, removeError);
+                           compacting = false; });
+}
+
+bool PlayerProfileManager::writeSnapshot(const vector<PlayerStats> &snapshot) const
+{
+    // Written beside the snapshot and renamed over it once durable
+    const string tempFile = filename + ".tmp";
+    error_code ec;
+    filesystem::remove(tempFile, ec);
+
+    string contents;
+    for (const PlayerStats &stats : snapshot)
+        contents += formatProfile(stats);
+
+    AppendFile file;
+    bool written = file.open(tempFile) && file.append(contents) && file.sync();
+    file.close();
+    if (written)
+        filesystem::rename(tempFile, filename, ec);
+    if (!written || ec)
     {
         cerr << "Error: Unable to save player profiles to " << filename << endl;
+        filesystem::remove(tempFile, ec);
+        return false;
     }
+    return true;
 }
 
-void PlayerProfileManager::loadProfiles()
+size_t PlayerProfileManager::replay(const string &path, bool truncateTornTail)
 {
-    ifstream file(filename);
+    ifstream file(path, ios::binary);
     if (!file.is_open())
-        return;
+        return 0;
+
+    string contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    file.close();
 
+    // Only newline-terminated records were completely written
+    size_t complete = contents.rfind('\n');
+    complete = complete == string::npos ? 0 : complete + 1;
+    if (truncateTornTail && complete < contents.size())
+    {
+        error_code ec;
+        filesystem::resize_file(path, complete, ec);
+    }
+
+    size_t records = 0;
+    stringstream lines(contents.substr(0, complete));
     string line;
-    while (getline(file, line))
+    while (getline(lines, line))
     {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
         if (line.empty())
             continue;
 
-        vector<string> tokens;
-        stringstream ss(line);
-        string token;
-
-        while (getline(ss, token, '|'))
+        PlayerStats stats;
+        if (parseProfile(line, stats))
         {
-            tokens.push_back(token);
+            profiles[stats.name] = stats;
+            records++;
         }
+    }
+    return records;
+}
 
-        if (tokens.size() >= 5)
-        {
-            PlayerStats stats(tokens[0], tokens[1]);
-            stats.gamesPlayed = stoi(tokens[2]);
-            stats.totalWinnings = stoll(tokens[3]);
-            stats.maxLevel = stoi(tokens[4]);
-            profiles[tokens[0]] = stats;
-        }
+void PlayerProfileManager::loadProfiles()
+{
+    lock_guard<mutex> ioLock(journalMutex);
+    bool interrupted;
+    {
+        lock_guard<mutex> lock(profilesMutex);
+        profiles.clear();
+        pendingJournal.clear();
+        pendingRecords = 0;
+        replay(filename, false);
+        interrupted = replay(compactingFile, false) > 0;
+        journalRecords = replay(journalFile, true);
     }
-    file.close();
-}
\ No newline at end of file
+
+    if (!journal.open(journalFile))
+        cerr << "Error: Unable to open " << journalFile << endl;
+
+    // Finish a compaction the last run did not get to complete
+    error_code ec;
+    if (interrupted || filesystem::exists(compactingFile, ec))
+        startCompaction();
+}
@@ -1,11 +1,16 @@
 #ifndef PLAYER_PROFILE_HPP
 #define PLAYER_PROFILE_HPP
 
+#include "append_file.hpp"
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 using namespace std;
 
@@ -22,21 +27,53 @@ struct PlayerStats
         : name(n), gender(g), gamesPlayed(0), totalWinnings(0), maxLevel(0), winRate(0.0) {}
 };
 
+// Profiles live in a snapshot (player_profiles.txt) plus a journal of
+// name|gender|games|winnings|maxLevel records, one per change, so saving a
+// game costs the same however many profiles exist. Changes are buffered in
+// memory; saveProfiles() appends the batch and fsyncs it once (the
+// persistence worker calls it). The journal is folded into the snapshot on a
+// background thread once it grows past the profile count. Startup replays
+// snapshot, then journal. Thread safe.
 class PlayerProfileManager
 {
 private:
     unordered_map<string, PlayerStats> profiles;
 
     const string filename = "docs/player_profiles.txt";
+    const string journalFile = "docs/player_profiles.journal";
+    const string compactingFile = "docs/player_profiles.journal.old"; // journal being folded into the snapshot
+
+    static constexpr size_t MIN_COMPACT_RECORDS = 256;
+
+    mutable mutex profilesMutex; // profiles and the pending batch
+    string pendingJournal;       // records not yet written
+    size_t pendingRecords;
+
+    mutex journalMutex; // journal I/O and compaction
+    AppendFile journal;
+    size_t journalRecords;
+    thread compactor;
+    atomic<bool> compacting;
+
+    static string formatProfile(const PlayerStats &stats);
+    static bool parseProfile(const string &line, PlayerStats &stats);
+    size_t replay(const string &path, bool truncateTornTail); // records applied
+    void appendRecord(const PlayerStats &stats);
+    void startCompaction();
+    bool writeSnapshot(const vector<PlayerStats> &snapshot) const;
 
 public:
     PlayerProfileManager();
+    ~PlayerProfileManager();
+
+    PlayerProfileManager(const PlayerProfileManager &) = delete;
+    PlayerProfileManager &operator=(const PlayerProfileManager &) = delete;
 
     PlayerStats getOrCreateProfile(const string &name, const string &gender);
     void updatePlayerStats(const string &name, long long winnings, int level, int questionsAnswered);
     bool playerExists(const string &name) const;
-    void saveProfiles() const;
+    void saveProfiles(); // writes and fsyncs every change so far as one batch
     void loadProfiles();
 };
 
-#endif
\ No newline at end of file
+#endif
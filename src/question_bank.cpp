@@ -1,6 +1,11 @@
 #include "question_bank.hpp"
-#include <algorithm> 
-#include <random>    
+#include "parallel.hpp"
+#include "hashing.hpp"
+#include <algorithm>
+#include <random>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
 
 using namespace std;
 
@@ -19,6 +24,27 @@ vector<int> CategoryNetwork::getQuestionsForCategory(int categoryId) const
     return vector<int>();
 }
 
+void CategoryNetwork::merge(const CategoryNetwork &other)
+{
+    for (const auto &entry : other.categoryMap)
+    {
+        vector<int> &ids = categoryMap[entry.first];
+        ids.insert(ids.end(), entry.second.begin(), entry.second.end());
+    }
+}
+
+vector<int> CategoryNetwork::getCategories() const
+{
+    vector<int> categories;
+    categories.reserve(categoryMap.size());
+    for (const auto &entry : categoryMap)
+    {
+        categories.push_back(entry.first);
+    }
+    sort(categories.begin(), categories.end());
+    return categories;
+}
+
 void CategoryNetwork::displayCategoryInfo() const
 {
     cout << "\n========== CATEGORY NETWORK ==========\n";
@@ -29,9 +55,89 @@ void CategoryNetwork::displayCategoryInfo() const
     cout << "======================================\n";
 }
 
-QuestionBank::QuestionBank() {}
+QuestionBank::QuestionBank() : records(nullptr), recordCount(0), strings(nullptr), paged(false) {}
+
+static bool parseInt(string_view field, int &value)
+{
+    auto result = from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == errc() && result.ptr == field.data() + field.size();
+}
+
+static bool hasPackExtension(const string &filename)
+{
+    const string extension = ".qpack";
+    return filename.size() >= extension.size() &&
+           filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+string QuestionBank::currentPackFor(const string &textFile)
+{
+    filesystem::path pack(textFile);
+    pack.replace_extension(".qpack");
+    error_code ec;
+    if (!filesystem::exists(pack, ec))
+        return "";
+    if (!filesystem::exists(textFile, ec))
+        return pack.string();
+    // Editing the text makes the pack stale until it is compiled again
+    if (filesystem::last_write_time(pack, ec) < filesystem::last_write_time(textFile, ec))
+        return "";
+    return pack.string();
+}
+
+bool QuestionBank::loadFromFile(const string &filename, LoadMode mode, unsigned threads)
+{
+    ownedRecords.clear();
+    arena.clear();
+    packFile.close();
+    records = nullptr;
+    recordCount = 0;
+    strings = nullptr;
+    paged = false;
+    pagedFile.close();
+    pageCache.clear();
+    questionIndex.clear();
+    categoryNetwork = CategoryNetwork();
+
+    if (hasPackExtension(filename))
+        mode = LoadMode::PACK;
+
+    bool loaded = false;
+    switch (mode)
+    {
+    case LoadMode::STREAM:
+        loaded = loadStream(filename);
+        break;
+    case LoadMode::MAPPED:
+        loaded = loadMapped(filename);
+        break;
+    case LoadMode::PARALLEL:
+        loaded = loadParallel(filename, threads);
+        break;
+    case LoadMode::PACK:
+        loaded = loadPack(filename);
+        break;
+    case LoadMode::PAGED:
+        loaded = loadPaged(filename);
+        break;
+    }
+
+    if (!loaded)
+        return false;
+
+    if (mode != LoadMode::PACK)
+    {
+        records = ownedRecords.data();
+        recordCount = ownedRecords.size();
+        strings = paged ? nullptr : arena.data();
+    }
+
+    buildIndexes(threads);
+    shuffleQuestions();
+    return true;
+}
 
-bool QuestionBank::loadFromFile(const string &filename)
+bool QuestionBank::loadStream(const string &filename)
 {
     ifstream file(filename);
     if (!file.is_open())
@@ -40,13 +146,11 @@ bool QuestionBank::loadFromFile(const string &filename)
         return false;
     }
 
-    // RNG for shuffling options
-    unsigned seed = (unsigned)time(0);
-    default_random_engine rng(seed);
-
     string line;
     while (getline(file, line))
     {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
         if (line.empty())
             continue;
 
@@ -62,90 +166,634 @@ bool QuestionBank::loadFromFile(const string &filename)
         if (tokens.size() < 9)
             continue;
 
-        Question q;
-        q.id = stoi(tokens[0]);
-        q.category = stoi(tokens[1]);
-        q.text = tokens[2];
+        int id, category, correctIndex;
+        if (!parseInt(tokens[0], id) || !parseInt(tokens[1], category) || !parseInt(tokens[7], correctIndex))
+            continue;
 
-        // Load original options
-        vector<string> rawOptions = {tokens[3], tokens[4], tokens[5], tokens[6]};
-        int originalCorrectIndex = stoi(tokens[7]);
+        // Optional 10th field: difficulty 1-3
+        int difficulty = 0;
+        if (tokens.size() == 10 && !parseInt(tokens[9], difficulty))
+            difficulty = 0;
 
-        // FIX: Shuffle logic
-        // 1. Identify the correct answer string
-        string correctAnswer = rawOptions[originalCorrectIndex];
+        string_view options[4] = {tokens[3], tokens[4], tokens[5], tokens[6]};
+        appendRecord(ownedRecords, arena, id, category, tokens[2], options, correctIndex, tokens[8], difficulty);
+    }
+
+    file.close();
+    return true;
+}
 
-        // 2. Shuffle the options vector
-        q.options = rawOptions;
-        shuffle(q.options.begin(), q.options.end(), rng);
+bool QuestionBank::loadMapped(const string &filename)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        cerr << "Error: Could not open " << filename << endl;
+        return false;
+    }
+
+    // Every string of the file fits in an arena the size of the file, so
+    // appending never reallocates.
+    arena.reserve(file.size());
+    parseLines(file.data(), file.data() + file.size(), ownedRecords, arena);
+    return true;
+}
+
+bool QuestionBank::loadParallel(const string &filename, unsigned threads)
+{
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        cerr << "Error: Could not open " << filename << endl;
+        return false;
+    }
+
+    // Small files are not worth a thread each
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+    const char *data = file.data();
+    size_t size = file.size();
+    threads = (unsigned)min<size_t>(resolveThreadCount(threads), size / MIN_CHUNK_BYTES + 1);
+    if (threads <= 1)
+    {
+        arena.reserve(size);
+        parseLines(data, data + size, ownedRecords, arena);
+        return true;
+    }
+
+    // Split on line boundaries, a few chunks per thread for load balance
+    size_t chunkCount = (size_t)threads * 4;
+    vector<const char *> bounds(chunkCount + 1);
+    bounds[0] = data;
+    bounds[chunkCount] = data + size;
+    for (size_t c = 1; c < chunkCount; c++)
+    {
+        const char *split = max(bounds[c - 1], data + size * c / chunkCount);
+        const char *newline = static_cast<const char *>(memchr(split, '\n', data + size - split));
+        bounds[c] = newline ? newline + 1 : data + size;
+    }
+
+    vector<vector<QuestionRecord>> chunkRecords(chunkCount);
+    vector<vector<char>> chunkStrings(chunkCount);
+    parallelFor(chunkCount, threads, [&](size_t c)
+                {
+                    chunkStrings[c].reserve(bounds[c + 1] - bounds[c]);
+                    parseLines(bounds[c], bounds[c + 1], chunkRecords[c], chunkStrings[c]); });
+
+    // Merge in input order: size everything once, then copy chunks in parallel
+    vector<size_t> recordBase(chunkCount + 1, 0), stringBase(chunkCount + 1, 0);
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+        recordBase[c + 1] = recordBase[c] + chunkRecords[c].size();
+        stringBase[c + 1] = stringBase[c] + chunkStrings[c].size();
+    }
+    ownedRecords.resize(recordBase[chunkCount]);
+    arena.resize(stringBase[chunkCount]);
 
-        // 3. Find the new index of the correct answer
-        for (int i = 0; i < 4; i++)
+    parallelFor(chunkCount, threads, [&](size_t c)
+                {
+                    copy(chunkStrings[c].begin(), chunkStrings[c].end(), arena.begin() + stringBase[c]);
+                    for (size_t i = 0; i < chunkRecords[c].size(); i++)
+                    {
+                        QuestionRecord record = chunkRecords[c][i];
+                        record.textOffset += stringBase[c];
+                        ownedRecords[recordBase[c] + i] = record;
+                    }
+                    vector<QuestionRecord>().swap(chunkRecords[c]);
+                    vector<char>().swap(chunkStrings[c]); });
+    return true;
+}
+
+void QuestionBank::parseLines(const char *begin, const char *end, vector<QuestionRecord> &out, vector<char> &strings)
+{
+    const char *cursor = begin;
+    while (cursor < end)
+    {
+        const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+        if (!lineEnd)
+            lineEnd = end;
+        string_view line(cursor, lineEnd - cursor);
+        cursor = lineEnd + 1;
+
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+
+        string_view tokens[11];
+        size_t count = splitFields(line, tokens);
+
+        int id, category, correctIndex, difficulty;
+        if (!parseHeader(tokens, count, id, category, correctIndex, difficulty))
+            continue;
+
+        appendRecord(out, strings, id, category, tokens[2], &tokens[3], correctIndex, tokens[8], difficulty);
+    }
+}
+
+size_t QuestionBank::splitFields(string_view line, string_view tokens[11])
+{
+    size_t count = 0;
+    while (count < 11)
+    {
+        size_t bar = line.find('|');
+        tokens[count++] = line.substr(0, bar);
+        if (bar == string_view::npos)
+            break;
+        line.remove_prefix(bar + 1);
+    }
+    return count;
+}
+
+bool QuestionBank::parseHeader(const string_view tokens[11], size_t count, int &id, int &category,
+                               int &correctIndex, int &difficulty)
+{
+    if (count < 9)
+        return false;
+    if (!parseInt(tokens[0], id) || !parseInt(tokens[1], category) || !parseInt(tokens[7], correctIndex))
+        return false;
+    if (correctIndex < 0 || correctIndex > 3)
+        return false;
+
+    // Optional 10th field: difficulty 1-3
+    difficulty = 0;
+    if (count == 10 && (!parseInt(tokens[9], difficulty) || difficulty < MIN_DIFFICULTY || difficulty > MAX_DIFFICULTY))
+        difficulty = 0;
+    return true;
+}
+
+bool QuestionBank::appendRecord(vector<QuestionRecord> &out, vector<char> &strings,
+                                int id, int category, string_view text, const string_view options[4],
+                                int correctIndex, string_view hint, int difficulty)
+{
+    if (correctIndex < 0 || correctIndex > 3)
+        return false;
+    if (difficulty < MIN_DIFFICULTY || difficulty > MAX_DIFFICULTY)
+        difficulty = 0;
+
+    size_t length = text.size() + hint.size() + 6;
+    for (int i = 0; i < 4; i++)
+        length += options[i].size();
+    if (length > UINT16_MAX)
+        return false;
+
+    QuestionRecord record = {};
+    record.id = id;
+    record.category = category;
+    record.textOffset = strings.size();
+    record.correctAnswerIndex = (uint8_t)correctIndex;
+    record.difficulty = (uint8_t)difficulty;
+
+    strings.insert(strings.end(), text.begin(), text.end());
+    strings.push_back('\0');
+    for (int i = 0; i < 4; i++)
+    {
+        record.fieldOffsets[i] = (uint16_t)(strings.size() - record.textOffset);
+        strings.insert(strings.end(), options[i].begin(), options[i].end());
+        strings.push_back('\0');
+    }
+    record.fieldOffsets[4] = (uint16_t)(strings.size() - record.textOffset);
+    strings.insert(strings.end(), hint.begin(), hint.end());
+    strings.push_back('\0');
+    record.fieldOffsets[5] = (uint16_t)(strings.size() - record.textOffset);
+
+    out.push_back(record);
+    return true;
+}
+
+bool QuestionBank::loadPaged(const string &filename)
+{
+    pagedFile.open(filename, ios::binary);
+    if (!pagedFile.is_open())
+    {
+        cerr << "Error: Could not open " << filename << endl;
+        return false;
+    }
+
+    // Only the records stay resident. textOffset is the file offset of the
+    // text field and the page runs to the end of the hint; the correct index
+    // field sits between the last option and the hint and is skipped over.
+    string line;
+    uint64_t lineStart = 0;
+    while (getline(pagedFile, line))
+    {
+        uint64_t nextLine = lineStart + line.size() + 1;
+        string_view view(line);
+        if (!view.empty() && view.back() == '\r')
+            view.remove_suffix(1);
+
+        string_view tokens[11];
+        size_t count = view.empty() ? 0 : splitFields(view, tokens);
+
+        int id, category, correctIndex, difficulty;
+        if (parseHeader(tokens, count, id, category, correctIndex, difficulty))
         {
-            if (q.options[i] == correctAnswer)
+            const char *text = tokens[2].data();
+            size_t pageLength = tokens[8].data() + tokens[8].size() - text + 1;
+            if (pageLength <= UINT16_MAX)
             {
-                q.correctAnswerIndex = i;
-                break;
+                QuestionRecord record = {};
+                record.id = id;
+                record.category = category;
+                record.textOffset = lineStart + (uint64_t)(text - line.data());
+                for (int i = 0; i < 4; i++)
+                    record.fieldOffsets[i] = (uint16_t)(tokens[3 + i].data() - text);
+                record.fieldOffsets[4] = (uint16_t)(tokens[8].data() - text);
+                record.fieldOffsets[5] = (uint16_t)pageLength;
+                record.correctAnswerIndex = (uint8_t)correctIndex;
+                record.difficulty = (uint8_t)difficulty;
+                ownedRecords.push_back(record);
             }
         }
+        lineStart = nextLine;
+    }
+
+    pagedFile.clear(); // the scan stopped at EOF; pages are read with seeks
+    paged = true;
+    return true;
+}
 
-        q.hint = tokens[8];
+void QuestionBank::setPageCacheBudget(size_t bytes)
+{
+    lock_guard<mutex> lock(pageMutex);
+    pageCache.setBudget(bytes);
+}
 
-        questions.push_back(q);
-        answers[q.id] = q.options[q.correctAnswerIndex];
+size_t QuestionBank::getPageCacheBytes() const
+{
+    lock_guard<mutex> lock(pageMutex);
+    return pageCache.getUsedBytes();
+}
 
-        categoryNetwork.addQuestionToCategory(q.category, q.id);
+bool QuestionBank::loadPack(const string &filename)
+{
+    if (!packFile.open(filename))
+    {
+        cerr << "Error: Could not open " << filename << endl;
+        return false;
     }
 
+    const char *base = packFile.data();
+    size_t size = packFile.size();
+
+    QuestionPackHeader header;
+    if (size < sizeof(header))
+    {
+        cerr << "Error: " << filename << " is too small to be a question pack" << endl;
+        return false;
+    }
+    memcpy(&header, base, sizeof(header));
+
+    if (memcmp(header.magic, QPACK_MAGIC, sizeof(header.magic)) != 0 || header.version != QPACK_VERSION)
+    {
+        cerr << "Error: " << filename << " is not a version " << QPACK_VERSION << " question pack" << endl;
+        return false;
+    }
+
+    // Bounds are checked with divisions so oversized counts cannot overflow.
+    if (header.recordOffset % alignof(QuestionRecord) != 0 || header.recordOffset > size ||
+        header.recordCount > (size - header.recordOffset) / sizeof(QuestionRecord) ||
+        header.stringOffset > size || header.stringSize > size - header.stringOffset ||
+        (header.stringSize > 0 && base[header.stringOffset + header.stringSize - 1] != '\0'))
+    {
+        cerr << "Error: " << filename << " has a corrupt header" << endl;
+        return false;
+    }
+
+    records = reinterpret_cast<const QuestionRecord *>(base + header.recordOffset);
+    recordCount = header.recordCount;
+    strings = base + header.stringOffset;
+
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        const QuestionRecord &record = records[i];
+        // Fields in order and the last one ending inside the blob keep every
+        // string of the record inside it
+        bool ordered = true;
+        for (int field = 1; field < 6; field++)
+            ordered = ordered && record.fieldOffsets[field - 1] <= record.fieldOffsets[field];
+        if (record.correctAnswerIndex > 3 || record.textOffset > header.stringSize || !ordered ||
+            record.fieldOffsets[5] > header.stringSize - record.textOffset)
+        {
+            cerr << "Error: " << filename << " has a corrupt record at index " << i << endl;
+            records = nullptr;
+            recordCount = 0;
+            strings = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QuestionBank::saveToPack(const string &filename) const
+{
+    if (paged)
+    {
+        cerr << "Error: a paged question bank cannot be saved as a pack" << endl;
+        return false;
+    }
+
+    // Written beside the target and renamed over it, so a running game that
+    // has the old pack mapped keeps reading the old file
+    const string tempFile = filename + ".tmp";
+    ofstream file(tempFile, ios::binary);
+    if (!file.is_open())
+    {
+        cerr << "Error: Could not write " << filename << endl;
+        return false;
+    }
+
+    size_t stringSize = 0;
+    if (recordCount > 0)
+    {
+        const QuestionRecord &last = records[recordCount - 1];
+        stringSize = last.textOffset + last.fieldOffsets[5];
+    }
+
+    QuestionPackHeader header = {};
+    memcpy(header.magic, QPACK_MAGIC, sizeof(header.magic));
+    header.version = QPACK_VERSION;
+    header.recordCount = recordCount;
+    header.recordOffset = sizeof(QuestionPackHeader);
+    header.stringOffset = header.recordOffset + recordCount * sizeof(QuestionRecord);
+    header.stringSize = stringSize;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(records), recordCount * sizeof(QuestionRecord));
+    file.write(strings, stringSize);
     file.close();
-    shuffleQuestions();
+
+    error_code ec;
+    if (!file.fail())
+        filesystem::rename(tempFile, filename, ec);
+    if (file.fail() || ec)
+    {
+        cerr << "Error: Could not write " << filename << endl;
+        filesystem::remove(tempFile, ec);
+        return false;
+    }
     return true;
 }
 
+void QuestionBank::buildIndexes(unsigned threads)
+{
+    const size_t MIN_RECORDS_PER_THREAD = 1 << 16;
+    threads = (unsigned)min<size_t>(resolveThreadCount(threads), recordCount / MIN_RECORDS_PER_THREAD + 1);
+
+    questionIndex.build(records, recordCount, threads);
+    if (questionIndex.size() < recordCount)
+    {
+        cout << "Skipped " << recordCount - questionIndex.size() << " questions with duplicate IDs\n";
+    }
+
+    // Each thread builds the category network of its own slice; the networks
+    // are merged in record order afterwards.
+    vector<CategoryNetwork> partial(threads);
+    parallelFor(threads, threads, [&](size_t c)
+                {
+                    size_t first = recordCount * c / threads;
+                    size_t last = recordCount * (c + 1) / threads;
+                    for (size_t i = first; i < last; i++)
+                    {
+                        const QuestionRecord &record = records[i];
+                        if (isCanonical(i))
+                            partial[c].addQuestionToCategory(record.category, record.id);
+                    } });
+
+    for (const CategoryNetwork &network : partial)
+    {
+        categoryNetwork.merge(network);
+    }
+
+    selector.build(*this);
+}
+
+bool QuestionBank::isCanonical(size_t recordIndex) const
+{
+    return questionIndex.find(records[recordIndex].id) == (int)recordIndex;
+}
+
 void QuestionBank::shuffleQuestions()
 {
+    drawOrder.clear();
+    drawOrder.reserve(questionIndex.size());
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        if (isCanonical(i))
+            drawOrder.push_back((int)i);
+    }
+
     srand((unsigned)time(0));
-    for (int i = questions.size() - 1; i > 0; --i)
+    for (int i = drawOrder.size() - 1; i > 0; --i)
     {
         int j = rand() % (i + 1);
-        swap(questions[i], questions[j]);
+        swap(drawOrder[i], drawOrder[j]);
+    }
+}
+
+Question QuestionBank::getQuestion(size_t recordIndex, unsigned char optionOrder) const
+{
+    if (!paged)
+        return buildQuestion(recordIndex, getString(records[recordIndex], 0), optionOrder);
+
+    lock_guard<mutex> lock(pageMutex);
+    shared_ptr<const vector<char>> page = pageCache.find(recordIndex);
+    if (!page)
+    {
+        // Read text..hint in one go and cut it into NUL-terminated fields.
+        // Bytes past the end of a shortened file read as NUL.
+        const QuestionRecord &record = records[recordIndex];
+        vector<char> data(record.fieldOffsets[5], '\0');
+        pagedFile.clear();
+        pagedFile.seekg((streamoff)record.textOffset);
+        pagedFile.read(data.data(), (streamsize)data.size());
+        replace(data.begin(), data.end(), '|', '\0');
+        data.back() = '\0';
+        page = pageCache.insert(recordIndex, move(data));
     }
+    Question q = buildQuestion(recordIndex, page->data(), optionOrder);
+    q.page = move(page);
+    return q;
+}
+
+Question QuestionBank::buildQuestion(size_t recordIndex, const char *text, unsigned char optionOrder) const
+{
+    const QuestionRecord &record = records[recordIndex];
+
+    Question q;
+    q.id = record.id;
+    q.category = record.category;
+    q.recordIndex = (int)recordIndex;
+    q.text = text;
+    for (int i = 0; i < 4; i++)
+        q.options[i] = text + record.fieldOffsets[i];
+    q.correctAnswerIndex = record.correctAnswerIndex;
+    q.hint = text + record.fieldOffsets[4];
+    q.optionOrder = optionOrder;
+    return q;
+}
+
+Question QuestionBank::noMoreQuestions()
+{
+    Question q;
+    q.text = "No more questions";
+    return q;
 }
 
 Question QuestionBank::getNextQuestion(const Player &player)
 {
-    for (const auto &q : questions)
+    // From a random record, the first unasked canonical record after it,
+    // wrapping around; the asked set skips asked runs a word at a time.
+    uint32_t limit = (uint32_t)recordCount;
+    uint32_t start = limit > 0 ? (uint32_t)(rand() % limit) : 0;
+    for (int pass = 0; pass < 2; pass++)
     {
-        if (!player.hasAskedQuestion(q.id))
+        uint32_t from = pass == 0 ? start : 0;
+        uint32_t end = pass == 0 ? limit : start;
+        for (uint32_t i = player.questionsAsked.nextAbsent(from, end); i < end;
+             i = player.questionsAsked.nextAbsent(i + 1, end))
         {
-            return q;
+            if (isCanonical(i))
+                return getQuestion(i, (unsigned char)(rand() % 24));
         }
     }
-    return Question{-1, 0, "No more questions", {}, -1, ""};
+    return noMoreQuestions();
 }
 
-const string &QuestionBank::getCorrectAnswer(int questionID) const
+Question QuestionBank::getNextQuestion(QuestionDraw &draw) const
 {
-    return answers.at(questionID);
+    uint64_t position;
+    if (!draw.next(position) || position >= drawOrder.size())
+    {
+        return noMoreQuestions();
+    }
+    return getQuestion(drawOrder[position], sessionOptionOrder(draw.getSeed(), drawOrder[position]));
 }
 
-bool QuestionBank::isCorrectAnswer(int questionID, int optionIndex) const
+void QuestionBank::startSession(SelectionState &state, uint64_t seed, const QuestionSet *seen) const
 {
-    if (questions.empty())
+    selector.startSession(state, seed, seen);
+}
+
+Question QuestionBank::selectQuestion(SelectionState &state, int difficulty, const string &mode) const
+{
+    int index = selector.select(state, difficulty, mode);
+    if (index < 0)
+    {
+        return noMoreQuestions();
+    }
+    return getQuestion(index, sessionOptionOrder(state.seed, index));
+}
+
+unsigned char QuestionBank::sessionOptionOrder(uint64_t seed, size_t recordIndex)
+{
+    // Same order for a question within one session, independent across sessions
+    return (unsigned char)(mix64(seed ^ mix64(recordIndex)) % 24);
+}
+
+bool QuestionBank::loadCategoryMixes(const string &filename)
+{
+    ifstream file(filename);
+    if (!file.is_open())
         return false;
-    for (const auto &q : questions)
+
+    unordered_map<string, unordered_map<int, double>> mixes;
+    string line;
+    while (getline(file, line))
     {
-        if (q.id == questionID)
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        vector<string> tokens;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, '|'))
         {
-            return q.correctAnswerIndex == optionIndex;
+            tokens.push_back(token);
         }
+
+        int category;
+        if (tokens.size() != 3 || !parseInt(tokens[1], category))
+            continue;
+
+        char *end = nullptr;
+        double weight = strtod(tokens[2].c_str(), &end);
+        if (end == tokens[2].c_str() || weight < 0)
+            continue;
+
+        mixes[tokens[0]][category] = weight;
     }
-    return false;
+    file.close();
+
+    for (const auto &mix : mixes)
+    {
+        setCategoryMix(mix.first, mix.second);
+    }
+    return true;
+}
+
+void QuestionBank::setCategoryMix(const string &mode, const unordered_map<int, double> &weights)
+{
+    selector.setCategoryMix(mode, weights);
+}
+
+bool QuestionBank::hasCategoryMix(const string &mode) const
+{
+    return selector.hasMode(mode);
+}
+
+string QuestionBank::getCorrectAnswer(int questionID) const
+{
+    int index = questionIndex.find(questionID);
+    if (index < 0)
+        return "";
+    if (paged)
+    {
+        Question q = getQuestion(index);
+        return q.options[q.correctAnswerIndex];
+    }
+    return getString(records[index], 1 + records[index].correctAnswerIndex);
+}
+
+bool QuestionBank::isCorrectAnswer(int questionID, int optionIndex, unsigned char optionOrder) const
+{
+    int index = questionIndex.find(questionID);
+    if (index < 0)
+        return false;
+    return displayedOptionIndex(optionOrder, records[index].correctAnswerIndex) == optionIndex;
+}
+
+int QuestionBank::findRecord(int questionID) const
+{
+    return questionIndex.find(questionID);
+}
+
+int QuestionBank::getDifficulty(const QuestionRecord &record)
+{
+    if (record.difficulty >= MIN_DIFFICULTY && record.difficulty <= MAX_DIFFICULTY)
+        return record.difficulty;
+
+    // Unrated questions are spread evenly so an unrated bank keeps a uniform mix
+    uint32_t spread = (uint32_t)record.id % (MAX_DIFFICULTY - MIN_DIFFICULTY + 1);
+    return MIN_DIFFICULTY + (int)spread;
+}
+
+int QuestionBank::getCategory(int questionID) const
+{
+    int index = questionIndex.find(questionID);
+    return index < 0 ? -1 : records[index].category;
 }
 
-int QuestionBank::getTotalQuestions() const { return questions.size(); }
+int QuestionBank::getTotalQuestions() const { return (int)questionIndex.size(); }
+
+const QuestionRecord *QuestionBank::getRecords() const { return records; }
 
-const vector<Question> &QuestionBank::getAllQuestions() const { return questions; }
+const char *QuestionBank::getString(const QuestionRecord &record, int field) const
+{
+    if (paged)
+        return nullptr;
+    size_t offset = record.textOffset + (field == 0 ? 0 : record.fieldOffsets[field - 1]);
+    return strings + offset;
+}
 
 string QuestionBank::getCategoryName(int categoryId) const
 {
@@ -2,43 +2,145 @@
 #define QUESTION_BANK_HPP
 
 #include "data_structures.hpp"
+#include "mapped_file.hpp"
+#include "question_index.hpp"
+#include "question_draw.hpp"
+#include "question_selector.hpp"
+#include "page_cache.hpp"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <ctime>
 #include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <mutex>
 
 using namespace std;
 
+// Fixed-layout question record. The strings of one question are stored back to
+// back and NUL terminated (text, options[0..3], hint) starting at textOffset in
+// the bank's string arena; fieldOffsets are relative to textOffset.
+struct QuestionRecord
+{
+    int32_t id;
+    int32_t category;
+    uint64_t textOffset;
+    uint16_t fieldOffsets[6]; // options[0..3], hint, end of record
+    uint8_t correctAnswerIndex;
+    uint8_t difficulty; // 1-3, 0 = unrated
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(QuestionRecord) == 32, "QuestionRecord is part of the .qpack format");
+
+// Compiled question pack (.qpack): this header, then recordCount QuestionRecords
+// at recordOffset, then the string blob at stringOffset. Little endian only.
+static constexpr char QPACK_MAGIC[4] = {'Q', 'P', 'A', 'K'};
+static constexpr uint32_t QPACK_VERSION = 1;
+
+struct QuestionPackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t recordCount;
+    uint64_t recordOffset;
+    uint64_t stringOffset;
+    uint64_t stringSize;
+};
+
+enum class LoadMode
+{
+    STREAM, // getline + stringstream per line
+    MAPPED,   // memory-mapped file, fields scanned in place into one arena
+    PARALLEL, // MAPPED, with line-aligned chunks parsed on a thread pool
+    PACK,     // memory-mapped .qpack, records and strings used in place
+    PAGED     // text file indexed only; question strings read on demand through an LRU cache
+};
+
 class CategoryNetwork {
 private:
     unordered_map<int, vector<int>> categoryMap; // category -> list of question IDs
-    
+
 public:
     void addQuestionToCategory(int categoryId, int questionId);
     vector<int> getQuestionsForCategory(int categoryId) const;
+    vector<int> getCategories() const; // ascending
+    void merge(const CategoryNetwork& other); // appends other's IDs after ours
     void displayCategoryInfo() const;
 };
 
 class QuestionBank {
 private:
-    vector<Question> questions;
-    unordered_map<int, string> answers; // ID -> correct answer
+    vector<QuestionRecord> ownedRecords; // text loads
+    vector<char> arena;                  // all question strings of a text load, NUL terminated
+    MappedFile packFile;                 // pack loads
+    const QuestionRecord* records;       // points into ownedRecords or packFile
+    size_t recordCount;
+    const char* strings;                 // points into arena or packFile; nullptr when paged
+    bool paged;                          // textOffset is a file offset into pagedFile
+    mutable ifstream pagedFile;
+    mutable PageCache pageCache;         // record index -> that record's strings
+    mutable mutex pageMutex;             // guards pagedFile and pageCache
+    vector<int> drawOrder;              // shuffled record indexes, one per distinct ID
+    QuestionIndex questionIndex;        // ID -> record index
     vector<Question> usedQuestions;
     CategoryNetwork categoryNetwork; // Category network instance
+    QuestionSelector selector;       // (category, difficulty) buckets over categoryNetwork
+
+    bool loadStream(const string& filename);
+    bool loadMapped(const string& filename);
+    bool loadParallel(const string& filename, unsigned threads);
+    bool loadPack(const string& filename);
+    bool loadPaged(const string& filename);
+    static size_t splitFields(string_view line, string_view tokens[11]);
+    static bool parseHeader(const string_view tokens[11], size_t count, int& id, int& category,
+                            int& correctIndex, int& difficulty);
+    static void parseLines(const char* begin, const char* end, vector<QuestionRecord>& out, vector<char>& strings);
+    static bool appendRecord(vector<QuestionRecord>& out, vector<char>& strings,
+                             int id, int category, string_view text, const string_view options[4],
+                             int correctIndex, string_view hint, int difficulty);
+    void buildIndexes(unsigned threads);
+    bool isCanonical(size_t recordIndex) const; // first record with its ID
+    Question buildQuestion(size_t recordIndex, const char* text, unsigned char optionOrder) const; // text = the record's first string
+    static Question noMoreQuestions();
 
 public:
     QuestionBank();
-    
-    bool loadFromFile(const string& filename);
+
+    QuestionBank(const QuestionBank&) = delete;
+    QuestionBank& operator=(const QuestionBank&) = delete;
+
+    // .qpack files always load as PACK; threads = 0 uses every core
+    bool loadFromFile(const string& filename, LoadMode mode = LoadMode::PARALLEL, unsigned threads = 0);
+    bool saveToPack(const string& filename) const; // not available for PAGED loads
+    static string currentPackFor(const string& textFile); // the .qpack beside it unless older, else empty
+    void setPageCacheBudget(size_t bytes);         // PAGED loads only
+    size_t getPageCacheBytes() const;
     void shuffleQuestions();
     Question getNextQuestion(const Player& player);
-    const string& getCorrectAnswer(int questionID) const;
-    bool isCorrectAnswer(int questionID, int optionIndex) const;
+    Question getNextQuestion(QuestionDraw& draw) const; // per-session order, O(1) per draw
+    void startSession(SelectionState& state, uint64_t seed, const QuestionSet* seen = nullptr) const; // seen: question IDs to serve last
+    Question selectQuestion(SelectionState& state, int difficulty, const string& mode) const;
+    bool loadCategoryMixes(const string& filename); // lines of mode|categoryId|weight
+    void setCategoryMix(const string& mode, const unordered_map<int, double>& weights);
+    bool hasCategoryMix(const string& mode) const;
+    // optionOrder: permutation code (0-23) the options are displayed in.
+    // No allocation unless a paged bank misses its cache.
+    Question getQuestion(size_t recordIndex, unsigned char optionOrder = 0) const;
+    static unsigned char sessionOptionOrder(uint64_t seed, size_t recordIndex);
+    string getCorrectAnswer(int questionID) const; // empty for unknown IDs
+    bool isCorrectAnswer(int questionID, int optionIndex, unsigned char optionOrder) const; // optionIndex as displayed
+    int getCategory(int questionID) const;
+    int findRecord(int questionID) const; // record index or -1
+    static int getDifficulty(const QuestionRecord& record);
     int getTotalQuestions() const;
-    const vector<Question>& getAllQuestions() const;
+    const QuestionRecord* getRecords() const;
+    const char* getString(const QuestionRecord& record, int field) const; // field 0 = text, 1-4 = options, 5 = hint; nullptr when paged
     string getCategoryName(int categoryId) const; // New method for category lookup
     CategoryNetwork& getCategoryNetwork() { return categoryNetwork; } // Access category network
+    const CategoryNetwork& getCategoryNetwork() const { return categoryNetwork; }
 };
 
 #endif
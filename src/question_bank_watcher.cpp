@@ -0,0 +1,169 @@
+#include "question_bank_watcher.hpp"
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// How often the stop flag is checked, and how long a burst of writes must
+// settle before the file is parsed
+static const int WAKE_INTERVAL_MS = 250;
+static const int SETTLE_MS = 200;
+
+QuestionBankWatcher::QuestionBankWatcher() : generation(0), running(false) {}
+
+QuestionBankWatcher::~QuestionBankWatcher()
+{
+    stop();
+}
+
+bool QuestionBankWatcher::start(const string &filename, Loader bankLoader)
+{
+    stop();
+    watchedFile = filename;
+    loader = bankLoader;
+
+    shared_ptr<QuestionBank> bank = load();
+    if (!bank)
+        return false;
+    atomic_store(&snapshot, shared_ptr<const QuestionBank>(bank));
+    generation++;
+
+    error_code ec;
+    lastWrite = filesystem::last_write_time(watchedFile, ec);
+    running = true;
+    worker = thread(&QuestionBankWatcher::watchLoop, this);
+    return true;
+}
+
+void QuestionBankWatcher::stop()
+{
+    running = false;
+    if (worker.joinable())
+        worker.join();
+}
+
+shared_ptr<const QuestionBank> QuestionBankWatcher::current() const
+{
+    return atomic_load(&snapshot);
+}
+
+uint64_t QuestionBankWatcher::getGeneration() const { return generation; }
+
+shared_ptr<QuestionBank> QuestionBankWatcher::load() const
+{
+    shared_ptr<QuestionBank> bank = make_shared<QuestionBank>();
+    if (!loader(*bank, watchedFile))
+        return nullptr;
+    if (bank->getTotalQuestions() == 0)
+    {
+        cerr << "Error: " << watchedFile << " has no questions" << endl;
+        return nullptr;
+    }
+    return bank;
+}
+
+void QuestionBankWatcher::watchLoop()
+{
+    int watchFd = openWatch();
+    while (waitForChange(watchFd))
+    {
+        // Editors often write a file in several steps; wait for them to finish
+        this_thread::sleep_for(chrono::milliseconds(SETTLE_MS));
+        if (!running)
+            break;
+
+        shared_ptr<QuestionBank> bank = load();
+        if (!bank)
+        {
+            cerr << "Keeping the current question bank" << endl;
+            continue;
+        }
+
+        atomic_store(&snapshot, shared_ptr<const QuestionBank>(bank));
+        generation++;
+        cout << "Reloaded " << bank->getTotalQuestions() << " questions from " << watchedFile << "\n";
+    }
+
+#ifdef __linux__
+    if (watchFd >= 0)
+        ::close(watchFd);
+#endif
+}
+
+int QuestionBankWatcher::openWatch() const
+{
+#ifdef __linux__
+    // Watch the directory rather than the file: editors and the pack compiler
+    // replace files by renaming, which would orphan a watch on the old inode.
+    filesystem::path path(watchedFile);
+    string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+bool QuestionBankWatcher::waitForChange(int watchFd)
+{
+    if (watchFd < 0)
+        return pollForChange();
+
+#ifdef __linux__
+    string name = filesystem::path(watchedFile).filename().string();
+    alignas(struct inotify_event) char buffer[4096];
+    bool changed = false;
+    while (running && !changed)
+    {
+        struct pollfd waiter = {watchFd, POLLIN, 0};
+        if (poll(&waiter, 1, WAKE_INTERVAL_MS) <= 0)
+            continue;
+
+        ssize_t length;
+        while ((length = read(watchFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *cursor = buffer; cursor < buffer + length;)
+            {
+                const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(cursor);
+                if (event->len > 0 && name == event->name)
+                    changed = true;
+                cursor += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+    return running;
+}
+
+bool QuestionBankWatcher::pollForChange()
+{
+    int waited = 0;
+    while (running)
+    {
+        this_thread::sleep_for(chrono::milliseconds(WAKE_INTERVAL_MS));
+        waited += WAKE_INTERVAL_MS;
+        if (waited < 1000)
+            continue;
+        waited = 0;
+
+        error_code ec;
+        auto writeTime = filesystem::last_write_time(watchedFile, ec);
+        if (!ec && writeTime != lastWrite)
+        {
+            lastWrite = writeTime;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef QUESTION_BANK_WATCHER_HPP
+#define QUESTION_BANK_WATCHER_HPP
+
+#include "question_bank.hpp"
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+
+using namespace std;
+
+// Owns the current question bank snapshot and reloads it when its file
+// changes. Reloads are parsed on a background thread and published with an
+// atomic pointer swap; snapshots already handed out stay valid and unchanged.
+class QuestionBankWatcher
+{
+public:
+    using Loader = function<bool(QuestionBank &bank, const string &filename)>;
+
+private:
+    string watchedFile;
+    Loader loader;
+    shared_ptr<const QuestionBank> snapshot; // only touched through atomic_load / atomic_store
+    atomic<uint64_t> generation;
+    atomic<bool> running;
+    thread worker;
+    filesystem::file_time_type lastWrite; // polling fallback
+
+    shared_ptr<QuestionBank> load() const; // nullptr on failure
+    void watchLoop();
+    int openWatch() const;              // inotify descriptor, -1 to poll instead
+    bool waitForChange(int watchFd);    // false once stop() was called
+    bool pollForChange();
+
+public:
+    QuestionBankWatcher();
+    ~QuestionBankWatcher();
+
+    QuestionBankWatcher(const QuestionBankWatcher &) = delete;
+    QuestionBankWatcher &operator=(const QuestionBankWatcher &) = delete;
+
+    // Loads the bank synchronously, then watches the file in the background
+    bool start(const string &filename, Loader bankLoader);
+    void stop();
+
+    shared_ptr<const QuestionBank> current() const;
+    uint64_t getGeneration() const; // bumped on every published reload
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "question_draw.hpp"
+#include "hashing.hpp"
+
+using namespace std;
+
+FeistelPermutation::FeistelPermutation(uint64_t size, uint64_t seed)
+    : domainSize(size), halfBits(1)
+{
+    while (halfBits < 32 && (1ull << (2 * halfBits)) < size)
+        halfBits++;
+    halfMask = (1ull << halfBits) - 1;
+
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        seed = mix64(seed);
+        roundKeys[i] = seed;
+    }
+}
+
+uint64_t FeistelPermutation::encrypt(uint64_t value) const
+{
+    uint64_t left = value >> halfBits;
+    uint64_t right = value & halfMask;
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        uint64_t next = left ^ (mix64(right ^ roundKeys[i]) & halfMask);
+        left = right;
+        right = next;
+    }
+    return (left << halfBits) | right;
+}
+
+uint64_t FeistelPermutation::size() const { return domainSize; }
+
+uint64_t FeistelPermutation::at(uint64_t position) const
+{
+    // The network permutes [0, 4^halfBits); walking the cycle until the value
+    // lands below size keeps it a bijection on [0, size).
+    uint64_t value = encrypt(position);
+    while (value >= domainSize)
+        value = encrypt(value);
+    return value;
+}
+
+QuestionDraw::QuestionDraw() : position(0), drawSeed(0) {}
+
+void QuestionDraw::reset(uint64_t size, uint64_t seed)
+{
+    permutation = FeistelPermutation(size, seed);
+    position = 0;
+    drawSeed = seed;
+}
+
+bool QuestionDraw::next(uint64_t &index)
+{
+    if (position >= permutation.size())
+        return false;
+    index = permutation.at(position++);
+    return true;
+}
+
+uint64_t QuestionDraw::drawnCount() const { return position; }
+
+uint64_t QuestionDraw::remaining() const { return permutation.size() - position; }
+
+uint64_t QuestionDraw::getSeed() const { return drawSeed; }
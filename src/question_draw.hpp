@@ -0,0 +1,48 @@
+#ifndef QUESTION_DRAW_HPP
+#define QUESTION_DRAW_HPP
+
+#include <cstdint>
+
+using namespace std;
+
+// Keyed bijection on [0, size): a 6-round Feistel network over the smallest
+// even-bit power of two covering size, cycle-walked back into range. Needs no
+// table, so any number of sessions can hold their own order of one bank.
+class FeistelPermutation
+{
+private:
+    static constexpr int ROUNDS = 6;
+
+    uint64_t domainSize;
+    int halfBits;
+    uint64_t halfMask;
+    uint64_t roundKeys[ROUNDS];
+
+    uint64_t encrypt(uint64_t value) const;
+
+public:
+    FeistelPermutation(uint64_t size = 0, uint64_t seed = 0);
+
+    uint64_t size() const;
+    uint64_t at(uint64_t position) const; // expected fewer than 4 rounds of walking
+};
+
+// Per-session draw state: a seed-keyed permutation plus a cursor.
+class QuestionDraw
+{
+private:
+    FeistelPermutation permutation;
+    uint64_t position;
+    uint64_t drawSeed;
+
+public:
+    QuestionDraw();
+
+    void reset(uint64_t size, uint64_t seed);
+    bool next(uint64_t &index); // false once every index has been drawn
+    uint64_t drawnCount() const;
+    uint64_t remaining() const;
+    uint64_t getSeed() const;
+};
+
+#endif
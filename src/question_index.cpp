@@ -0,0 +1,249 @@
+#include "question_index.hpp"
+#include "question_bank.hpp"
+#include "hashing.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+
+using namespace std;
+
+QuestionIndex::QuestionIndex() : records(nullptr), indexedCount(0), minId(0), seed(0) {}
+
+void QuestionIndex::clear()
+{
+    records = nullptr;
+    indexedCount = 0;
+    minId = 0;
+    dense.clear();
+    seed = 0;
+    displacements.clear();
+    slots.clear();
+}
+
+void QuestionIndex::build(const QuestionRecord *recs, size_t count, unsigned threads)
+{
+    clear();
+    records = recs;
+    if (count == 0)
+        return;
+    threads = (unsigned)min<size_t>(max(1u, threads), count);
+
+    vector<int32_t> lowest(threads, recs[0].id), highest(threads, recs[0].id);
+    parallelFor(threads, threads, [&](size_t t)
+                {
+                    for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++)
+                    {
+                        lowest[t] = min(lowest[t], recs[i].id);
+                        highest[t] = max(highest[t], recs[i].id);
+                    } });
+    minId = *min_element(lowest.begin(), lowest.end());
+    int32_t maxId = *max_element(highest.begin(), highest.end());
+
+    // A dense table is the cheapest lookup while ids cover about half their range
+    uint64_t range = (uint64_t)((int64_t)maxId - minId) + 1;
+    if (range <= 2 * (uint64_t)count + 1024)
+    {
+        buildDense(count, range, threads);
+        return;
+    }
+
+    while (!buildPerfectHash(count, threads))
+        seed = mix64(seed + 1);
+}
+
+void QuestionIndex::buildDense(size_t count, uint64_t range, unsigned threads)
+{
+    dense.assign(range, -1);
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            int32_t &slot = dense[records[i].id - minId];
+            if (slot < 0)
+            {
+                slot = (int32_t)i;
+                indexedCount++;
+            }
+        }
+        return;
+    }
+
+    // Each thread owns a slice of the ID range and scans every ID in record
+    // order, so the first record of a duplicate ID wins without any locking.
+    vector<int32_t> ids(count);
+    parallelFor(threads, threads, [&](size_t t)
+                {
+                    for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++)
+                        ids[i] = records[i].id; });
+
+    vector<size_t> found(threads, 0);
+    parallelFor(threads, threads, [&](size_t t)
+                {
+                    uint64_t sliceBegin = range * t / threads;
+                    uint64_t sliceEnd = range * (t + 1) / threads;
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        uint64_t offset = (uint64_t)((int64_t)ids[i] - minId);
+                        if (offset < sliceBegin || offset >= sliceEnd || dense[offset] >= 0)
+                            continue;
+                        dense[offset] = (int32_t)i;
+                        found[t]++;
+                    } });
+
+    for (size_t n : found)
+        indexedCount += n;
+}
+
+// Maps a 64-bit hash onto [0, n) without a division
+static size_t reduce(uint64_t hash, size_t n)
+{
+    return (size_t)(((hash >> 32) * (uint64_t)n) >> 32);
+}
+
+size_t QuestionIndex::bucketOf(int32_t id) const
+{
+    return reduce(mix64((uint64_t)(uint32_t)id ^ seed), displacements.size());
+}
+
+size_t QuestionIndex::slotOf(int32_t id, uint32_t displacement) const
+{
+    return reduce(mix64(((uint64_t)(uint32_t)id << 32 | displacement) ^ ~seed), slots.size());
+}
+
+bool QuestionIndex::buildPerfectHash(size_t count, unsigned threads)
+{
+    size_t bucketCount = count;
+    displacements.assign(bucketCount, 0);
+
+    // Counting sort of records into buckets; ids are copied alongside so the
+    // placement loop never touches the records themselves
+    vector<uint32_t> bucketStart(bucketCount + 1, 0);
+    vector<uint32_t> keyBucket(count);
+    parallelFor(threads, threads, [&](size_t t)
+                {
+                    for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++)
+                        keyBucket[i] = (uint32_t)bucketOf(records[i].id); });
+    for (size_t i = 0; i < count; i++)
+        bucketStart[keyBucket[i] + 1]++;
+    for (size_t b = 0; b < bucketCount; b++)
+        bucketStart[b + 1] += bucketStart[b];
+
+    vector<int32_t> bucketKeys(count);
+    vector<int32_t> bucketIds(count);
+    vector<uint32_t> bucketSize(bucketCount, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t b = keyBucket[i];
+        uint32_t first = bucketStart[b];
+        int32_t id = records[i].id;
+
+        // Equal ids always share a bucket; keep only the first record
+        bool duplicate = false;
+        for (uint32_t k = first; k < first + bucketSize[b]; k++)
+        {
+            if (bucketIds[k] == id)
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate)
+            continue;
+
+        bucketKeys[first + bucketSize[b]] = (int32_t)i;
+        bucketIds[first + bucketSize[b]] = id;
+        bucketSize[b]++;
+    }
+    keyBucket.clear();
+    keyBucket.shrink_to_fit();
+
+    size_t n = 0;
+    uint32_t largest = 0;
+    for (size_t b = 0; b < bucketCount; b++)
+    {
+        n += bucketSize[b];
+        largest = max(largest, bucketSize[b]);
+    }
+    slots.assign(n, -1);
+
+    // Place the largest buckets first, while the table is still empty
+    vector<uint32_t> sizeStart(largest + 2, 0);
+    for (size_t b = 0; b < bucketCount; b++)
+        sizeStart[largest - bucketSize[b] + 1]++;
+    for (uint32_t k = 0; k <= largest; k++)
+        sizeStart[k + 1] += sizeStart[k];
+    vector<uint32_t> order(bucketCount);
+    for (size_t b = 0; b < bucketCount; b++)
+        order[sizeStart[largest - bucketSize[b]]++] = (uint32_t)b;
+
+    vector<size_t> placed;
+    size_t nextFree = 0;
+    for (uint32_t b : order)
+    {
+        uint32_t first = bucketStart[b];
+        uint32_t size = bucketSize[b];
+        if (size == 0)
+            break;
+
+        if (size == 1)
+        {
+            // Singletons take any free slot directly
+            while (slots[nextFree] >= 0)
+                nextFree++;
+            slots[nextFree] = bucketKeys[first];
+            displacements[b] = DIRECT_SLOT | (uint32_t)nextFree;
+            continue;
+        }
+
+        bool done = false;
+        for (uint32_t d = 0; d < (1u << 20) && !done; d++)
+        {
+            placed.clear();
+            done = true;
+            for (uint32_t k = first; k < first + size; k++)
+            {
+                size_t slot = slotOf(bucketIds[k], d);
+                if (slots[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end())
+                {
+                    done = false;
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (done)
+            {
+                for (uint32_t k = 0; k < size; k++)
+                    slots[placed[k]] = bucketKeys[first + k];
+                displacements[b] = d;
+            }
+        }
+        if (!done)
+            return false;
+    }
+
+    indexedCount = n;
+    return true;
+}
+
+int QuestionIndex::find(int questionID) const
+{
+    if (!dense.empty())
+    {
+        int64_t offset = (int64_t)questionID - minId;
+        if (offset < 0 || offset >= (int64_t)dense.size())
+            return -1;
+        return dense[offset];
+    }
+
+    if (slots.empty())
+        return -1;
+
+    uint32_t displacement = displacements[bucketOf(questionID)];
+    size_t slot = (displacement & DIRECT_SLOT) ? (displacement & ~DIRECT_SLOT)
+                                               : slotOf(questionID, displacement);
+    int32_t index = slots[slot];
+    return (index >= 0 && records[index].id == questionID) ? index : -1;
+}
+
+size_t QuestionIndex::size() const { return indexedCount; }
+
+bool QuestionIndex::isDense() const { return !dense.empty(); }
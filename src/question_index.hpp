@@ -0,0 +1,44 @@
+#ifndef QUESTION_INDEX_HPP
+#define QUESTION_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+struct QuestionRecord;
+
+// Question id -> record index in O(1). Compact id ranges use a dense table;
+// sparse ids (merged packs, generated banks) get a minimal perfect hash built
+// with hash-and-displace. Duplicate ids resolve to their first record.
+class QuestionIndex
+{
+private:
+    const QuestionRecord *records;
+    size_t indexedCount;
+    int32_t minId;
+    vector<int32_t> dense;          // id - minId -> record index, -1 if absent
+
+    uint64_t seed;
+    vector<uint32_t> displacements; // per bucket; DIRECT_SLOT flag = slot stored directly
+    vector<int32_t> slots;          // perfect hash slot -> record index
+
+    static constexpr uint32_t DIRECT_SLOT = 0x80000000u;
+
+    void buildDense(size_t count, uint64_t range, unsigned threads);
+    bool buildPerfectHash(size_t count, unsigned threads);
+    size_t bucketOf(int32_t id) const;
+    size_t slotOf(int32_t id, uint32_t displacement) const;
+
+public:
+    QuestionIndex();
+
+    void build(const QuestionRecord *records, size_t count, unsigned threads = 1);
+    void clear();
+    int find(int questionID) const; // record index or -1
+    size_t size() const;
+    bool isDense() const;
+};
+
+#endif
@@ -0,0 +1,224 @@
+#include "question_selector.hpp"
+#include "question_bank.hpp"
+#include "hashing.hpp"
+
+using namespace std;
+
+void AliasTable::build(const vector<double> &weights)
+{
+    probability.clear();
+    alias.clear();
+
+    size_t n = weights.size();
+    double total = 0;
+    int positive = -1;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (weights[i] > 0)
+        {
+            total += weights[i];
+            positive = (int)i;
+        }
+    }
+    if (positive < 0)
+        return;
+
+    // Vose's variant: pair each under-full column with an over-full one
+    probability.assign(n, 0.0);
+    alias.assign(n, positive);
+    vector<double> scaled(n);
+    vector<int> small, large;
+    for (size_t i = 0; i < n; i++)
+    {
+        scaled[i] = weights[i] > 0 ? weights[i] * n / total : 0.0;
+        (scaled[i] < 1.0 ? small : large).push_back((int)i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        int under = small.back();
+        small.pop_back();
+        int over = large.back();
+        large.pop_back();
+
+        probability[under] = scaled[under];
+        alias[under] = over;
+        scaled[over] -= 1.0 - scaled[under];
+        (scaled[over] < 1.0 ? small : large).push_back(over);
+    }
+
+    // Leftovers are full columns up to rounding; zero weights must stay unreachable
+    for (int i : large)
+        probability[i] = 1.0;
+    for (int i : small)
+        probability[i] = weights[i] > 0 ? 1.0 : 0.0;
+}
+
+bool AliasTable::empty() const { return probability.empty(); }
+
+int AliasTable::sample(uint64_t random) const
+{
+    if (probability.empty())
+        return -1;
+    size_t column = (size_t)(((random >> 32) * (uint64_t)probability.size()) >> 32);
+    double coin = (double)(uint32_t)random / 4294967296.0;
+    return coin < probability[column] ? (int)column : alias[column];
+}
+
+SelectionState::SelectionState() : seed(0), counter(0), seen(nullptr) {}
+
+QuestionSelector::QuestionSelector() : records(nullptr) {}
+
+size_t QuestionSelector::bucketOf(size_t categorySlot, int difficulty) const
+{
+    return categorySlot * DIFFICULTIES + (difficulty - MIN_DIFFICULTY);
+}
+
+void QuestionSelector::build(const QuestionBank &bank)
+{
+    const CategoryNetwork &network = bank.getCategoryNetwork();
+    records = bank.getRecords();
+    categories = network.getCategories();
+    buckets.assign(categories.size() * DIFFICULTIES, vector<int>());
+
+    for (size_t slot = 0; slot < categories.size(); slot++)
+    {
+        for (int id : network.getQuestionsForCategory(categories[slot]))
+        {
+            int index = bank.findRecord(id);
+            if (index < 0)
+                continue;
+            int difficulty = QuestionBank::getDifficulty(bank.getRecords()[index]);
+            buckets[bucketOf(slot, difficulty)].push_back(index);
+        }
+    }
+
+    // Without a mix, categories are weighted by their share of the bank
+    defaultTables.assign(DIFFICULTIES, AliasTable());
+    for (int d = MIN_DIFFICULTY; d <= MAX_DIFFICULTY; d++)
+    {
+        vector<double> weights(categories.size());
+        for (size_t slot = 0; slot < categories.size(); slot++)
+            weights[slot] = (double)buckets[bucketOf(slot, d)].size();
+        defaultTables[d - MIN_DIFFICULTY].build(weights);
+    }
+    modeTables.clear();
+}
+
+void QuestionSelector::setCategoryMix(const string &mode, const unordered_map<int, double> &weights)
+{
+    vector<AliasTable> &tables = modeTables[mode];
+    tables.assign(DIFFICULTIES, AliasTable());
+    for (int d = MIN_DIFFICULTY; d <= MAX_DIFFICULTY; d++)
+    {
+        vector<double> slotWeights(categories.size(), 0.0);
+        for (size_t slot = 0; slot < categories.size(); slot++)
+        {
+            auto it = weights.find(categories[slot]);
+            if (it != weights.end() && !buckets[bucketOf(slot, d)].empty())
+                slotWeights[slot] = it->second;
+        }
+        tables[d - MIN_DIFFICULTY].build(slotWeights);
+    }
+}
+
+bool QuestionSelector::hasMode(const string &mode) const
+{
+    return modeTables.find(mode) != modeTables.end();
+}
+
+void QuestionSelector::startSession(SelectionState &state, uint64_t seed, const QuestionSet *seen) const
+{
+    state.seed = seed;
+    state.counter = 0;
+    state.seen = seen;
+    state.deferred.assign(buckets.size(), vector<int>());
+    state.bucketDraws.resize(buckets.size());
+    for (size_t b = 0; b < buckets.size(); b++)
+        state.bucketDraws[b].reset(buckets[b].size(), mix64(seed + b));
+}
+
+uint64_t QuestionSelector::nextRandom(SelectionState &state) const
+{
+    return mix64(state.seed ^ mix64(++state.counter));
+}
+
+int QuestionSelector::drawFromBucket(SelectionState &state, size_t bucket) const
+{
+    uint64_t position;
+    while (state.bucketDraws[bucket].next(position))
+    {
+        int index = buckets[bucket][position];
+        if (!state.seen || !state.seen->contains((uint32_t)records[index].id))
+            return index;
+        state.deferred[bucket].push_back(index);
+    }
+    return -1;
+}
+
+int QuestionSelector::select(SelectionState &state, int difficulty, const string &mode) const
+{
+    if (state.bucketDraws.size() != buckets.size() || buckets.empty())
+        return -1;
+
+    if (difficulty < MIN_DIFFICULTY)
+        difficulty = MIN_DIFFICULTY;
+    if (difficulty > MAX_DIFFICULTY)
+        difficulty = MAX_DIFFICULTY;
+
+    auto it = modeTables.find(mode);
+    const vector<AliasTable> &tables = (it != modeTables.end()) ? it->second : defaultTables;
+
+    // Requested difficulty first, then the nearest ones
+    int order[DIFFICULTIES];
+    int count = 0;
+    for (int distance = 0; count < DIFFICULTIES; distance++)
+    {
+        if (difficulty - distance >= MIN_DIFFICULTY)
+            order[count++] = difficulty - distance;
+        if (distance > 0 && difficulty + distance <= MAX_DIFFICULTY && count < DIFFICULTIES)
+            order[count++] = difficulty + distance;
+    }
+
+    // A few weighted samples per difficulty; a bucket this session has used
+    // up just costs another sample
+    const int SAMPLE_ATTEMPTS = 4;
+    for (int d : order)
+    {
+        const AliasTable &table = tables[d - MIN_DIFFICULTY];
+        for (int attempt = 0; attempt < SAMPLE_ATTEMPTS && !table.empty(); attempt++)
+        {
+            int slot = table.sample(nextRandom(state));
+            int index = drawFromBucket(state, bucketOf(slot, d));
+            if (index >= 0)
+                return index;
+        }
+    }
+
+    // The mix is exhausted: fall back to any question left
+    for (int d : order)
+    {
+        for (size_t slot = 0; slot < categories.size(); slot++)
+        {
+            int index = drawFromBucket(state, bucketOf(slot, d));
+            if (index >= 0)
+                return index;
+        }
+    }
+
+    // Only questions this profile has seen before are left
+    for (int d : order)
+    {
+        for (size_t slot = 0; slot < categories.size(); slot++)
+        {
+            vector<int> &deferred = state.deferred[bucketOf(slot, d)];
+            if (!deferred.empty())
+            {
+                int index = deferred.back();
+                deferred.pop_back();
+                return index;
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,74 @@
+#ifndef QUESTION_SELECTOR_HPP
+#define QUESTION_SELECTOR_HPP
+
+#include "question_draw.hpp"
+#include "question_set.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+class QuestionBank;
+struct QuestionRecord;
+
+static constexpr int MIN_DIFFICULTY = 1;
+static constexpr int MAX_DIFFICULTY = 3;
+
+// Walker's alias method: O(n) build, O(1) weighted sample.
+class AliasTable
+{
+private:
+    vector<double> probability;
+    vector<int> alias;
+
+public:
+    void build(const vector<double> &weights);
+    bool empty() const;
+    int sample(uint64_t random) const; // -1 if every weight was zero
+};
+
+// Per-session selection state: one keyed permutation per bucket. Questions
+// whose IDs are in seen are set aside and only served once the unseen ones
+// run out.
+struct SelectionState
+{
+    uint64_t seed;
+    uint64_t counter;
+    vector<QuestionDraw> bucketDraws;
+    const QuestionSet *seen;         // question IDs to avoid, or nullptr
+    vector<vector<int>> deferred;    // per bucket: seen record indexes drawn so far
+
+    SelectionState();
+};
+
+// Buckets the bank by (category, difficulty) from its CategoryNetwork and
+// draws a category per question with a per-game-mode weighted mix.
+class QuestionSelector
+{
+private:
+    static constexpr int DIFFICULTIES = MAX_DIFFICULTY - MIN_DIFFICULTY + 1;
+
+    const QuestionRecord *records;        // the bank's records, for IDs
+    vector<int> categories;               // distinct category IDs, ascending
+    vector<vector<int>> buckets;          // [slot * DIFFICULTIES + difficulty - 1] -> record indexes
+    vector<AliasTable> defaultTables;     // per difficulty, weighted by bucket size
+    unordered_map<string, vector<AliasTable>> modeTables; // game mode -> per difficulty
+
+    size_t bucketOf(size_t categorySlot, int difficulty) const;
+    int drawFromBucket(SelectionState &state, size_t bucket) const; // skips and defers seen questions
+    uint64_t nextRandom(SelectionState &state) const;
+
+public:
+    QuestionSelector();
+
+    void build(const QuestionBank &bank);
+    void setCategoryMix(const string &mode, const unordered_map<int, double> &weights);
+    bool hasMode(const string &mode) const;
+
+    void startSession(SelectionState &state, uint64_t seed, const QuestionSet *seen = nullptr) const;
+    int select(SelectionState &state, int difficulty, const string &mode) const; // record index or -1
+};
+
+#endif
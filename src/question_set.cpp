@@ -0,0 +1,237 @@
+#include "question_set.hpp"
+#include <algorithm>
+#include <functional>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+static int countTrailingZeros(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+bool QuestionSet::Container::contains(uint16_t low) const
+{
+    if (isBitmap())
+        return (bits[low >> 6] >> (low & 63)) & 1;
+    return binary_search(values.begin(), values.end(), low);
+}
+
+bool QuestionSet::Container::insert(uint16_t low)
+{
+    if (isBitmap())
+    {
+        uint64_t mask = (uint64_t)1 << (low & 63);
+        if (bits[low >> 6] & mask)
+            return false;
+        bits[low >> 6] |= mask;
+        cardinality++;
+        return true;
+    }
+
+    auto it = lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low)
+        return false;
+    values.insert(it, low);
+    cardinality++;
+
+    if (values.size() >= ARRAY_LIMIT)
+    {
+        bits.assign(BITMAP_WORDS, 0);
+        for (uint16_t v : values)
+            bits[v >> 6] |= (uint64_t)1 << (v & 63);
+        vector<uint16_t>().swap(values);
+    }
+    return true;
+}
+
+uint32_t QuestionSet::Container::nextAbsent(uint32_t low) const
+{
+    if (cardinality == 65536)
+        return 65536;
+
+    if (!isBitmap())
+    {
+        // Walk the run of consecutive present values starting at low
+        auto it = lower_bound(values.begin(), values.end(), (uint16_t)low);
+        while (it != values.end() && *it == low)
+        {
+            ++it;
+            low++;
+        }
+        return low;
+    }
+
+    // Word scan: the first zero bit at or after low
+    size_t word = low >> 6;
+    uint64_t unset = ~bits[word] & (~(uint64_t)0 << (low & 63));
+    while (unset == 0)
+    {
+        if (++word == BITMAP_WORDS)
+            return 65536;
+        unset = ~bits[word];
+    }
+    return (uint32_t)(word * 64 + countTrailingZeros(unset));
+}
+
+QuestionSet::QuestionSet() : count(0) {}
+
+const QuestionSet::Container *QuestionSet::findContainer(uint32_t key) const
+{
+    auto it = lower_bound(containers.begin(), containers.end(), key,
+                          [](const Container &c, uint32_t k)
+                          { return c.key < k; });
+    return it != containers.end() && it->key == key ? &*it : nullptr;
+}
+
+bool QuestionSet::insert(uint32_t value)
+{
+    uint32_t key = value >> 16;
+    auto it = lower_bound(containers.begin(), containers.end(), key,
+                          [](const Container &c, uint32_t k)
+                          { return c.key < k; });
+    if (it == containers.end() || it->key != key)
+    {
+        Container container;
+        container.key = key;
+        container.cardinality = 0;
+        it = containers.insert(it, move(container));
+    }
+
+    if (!it->insert((uint16_t)value))
+        return false;
+    count++;
+    return true;
+}
+
+bool QuestionSet::contains(uint32_t value) const
+{
+    const Container *container = findContainer(value >> 16);
+    return container && container->contains((uint16_t)value);
+}
+
+size_t QuestionSet::size() const { return count; }
+
+void QuestionSet::clear()
+{
+    containers.clear();
+    count = 0;
+}
+
+uint32_t QuestionSet::nextAbsent(uint32_t from, uint32_t limit) const
+{
+    while (from < limit)
+    {
+        const Container *container = findContainer(from >> 16);
+        if (!container)
+            return from;
+
+        uint32_t low = container->nextAbsent(from & 0xFFFF);
+        if (low < 65536)
+            return min((container->key << 16) | low, limit);
+
+        // This container is full from here on; continue with the next key
+        if ((from >> 16) == 0xFFFF)
+            break;
+        from = ((from >> 16) + 1) << 16;
+    }
+    return limit;
+}
+
+vector<uint32_t> QuestionSet::values() const
+{
+    vector<uint32_t> result;
+    result.reserve(count);
+    for (const Container &container : containers)
+    {
+        uint32_t base = container.key << 16;
+        if (!container.isBitmap())
+        {
+            for (uint16_t low : container.values)
+                result.push_back(base | low);
+            continue;
+        }
+        for (size_t word = 0; word < BITMAP_WORDS; word++)
+        {
+            for (uint64_t bits = container.bits[word]; bits; bits &= bits - 1)
+                result.push_back(base | (uint32_t)(word * 64 + countTrailingZeros(bits)));
+        }
+    }
+    return result;
+}
+
+void QuestionSet::write(ostream &out) const
+{
+    uint32_t containerCount = (uint32_t)containers.size();
+    out.write(reinterpret_cast<const char *>(&containerCount), sizeof(containerCount));
+    for (const Container &container : containers)
+    {
+        out.write(reinterpret_cast<const char *>(&container.key), sizeof(container.key));
+        out.write(reinterpret_cast<const char *>(&container.cardinality), sizeof(container.cardinality));
+        if (container.isBitmap())
+            out.write(reinterpret_cast<const char *>(container.bits.data()), BITMAP_WORDS * sizeof(uint64_t));
+        else
+            out.write(reinterpret_cast<const char *>(container.values.data()), container.values.size() * sizeof(uint16_t));
+    }
+}
+
+bool QuestionSet::read(istream &in)
+{
+    clear();
+
+    uint32_t containerCount;
+    if (!in.read(reinterpret_cast<char *>(&containerCount), sizeof(containerCount)))
+        return false;
+
+    for (uint32_t c = 0; c < containerCount; c++)
+    {
+        Container container;
+        if (!in.read(reinterpret_cast<char *>(&container.key), sizeof(container.key)) ||
+            !in.read(reinterpret_cast<char *>(&container.cardinality), sizeof(container.cardinality)) ||
+            container.cardinality == 0 || container.cardinality > 65536 ||
+            (!containers.empty() && container.key <= containers.back().key))
+        {
+            clear();
+            return false;
+        }
+
+        bool valid;
+        if (container.cardinality >= ARRAY_LIMIT)
+        {
+            container.bits.resize(BITMAP_WORDS);
+            valid = (bool)in.read(reinterpret_cast<char *>(container.bits.data()), BITMAP_WORDS * sizeof(uint64_t));
+
+            uint32_t bitCount = 0;
+            for (uint64_t word : container.bits)
+            {
+                for (; word; word &= word - 1)
+                    bitCount++;
+            }
+            valid = valid && bitCount == container.cardinality;
+        }
+        else
+        {
+            container.values.resize(container.cardinality);
+            valid = (bool)in.read(reinterpret_cast<char *>(container.values.data()), container.cardinality * sizeof(uint16_t)) &&
+                    adjacent_find(container.values.begin(), container.values.end(), greater_equal<uint16_t>()) == container.values.end();
+        }
+        if (!valid)
+        {
+            clear();
+            return false;
+        }
+
+        count += container.cardinality;
+        containers.push_back(move(container));
+    }
+    return true;
+}
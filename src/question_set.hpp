@@ -0,0 +1,57 @@
+#ifndef QUESTION_SET_HPP
+#define QUESTION_SET_HPP
+
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Set of question record indexes, roaring-bitmap style: values are grouped by
+// their high 16 bits, and each group is a sorted array of low halves until it
+// holds ARRAY_LIMIT values, then a 65536-bit bitmap. A session that asked a
+// handful of questions costs a few bytes however large the bank is.
+class QuestionSet
+{
+private:
+    static constexpr size_t ARRAY_LIMIT = 4096; // an array this big is as large as a bitmap
+    static constexpr size_t BITMAP_WORDS = 65536 / 64;
+
+    struct Container
+    {
+        uint32_t key;             // value >> 16
+        uint32_t cardinality;
+        vector<uint16_t> values;  // sorted low halves, while cardinality < ARRAY_LIMIT
+        vector<uint64_t> bits;    // BITMAP_WORDS words once converted
+
+        bool isBitmap() const { return !bits.empty(); }
+        bool contains(uint16_t low) const;
+        bool insert(uint16_t low);
+        uint32_t nextAbsent(uint32_t low) const; // 65536 if the rest of the container is full
+    };
+
+    vector<Container> containers; // sorted by key
+    size_t count;
+
+    const Container *findContainer(uint32_t key) const;
+
+public:
+    QuestionSet();
+
+    bool insert(uint32_t value); // false if it was already present
+    bool contains(uint32_t value) const;
+    size_t size() const;
+    void clear();
+
+    // Smallest value in [from, limit) that is not in the set, or limit
+    uint32_t nextAbsent(uint32_t from, uint32_t limit) const;
+    vector<uint32_t> values() const; // ascending
+
+    // Binary form: container count, then per container key, cardinality and
+    // its sorted uint16 array or 1024-word bitmap. Little endian.
+    void write(ostream &out) const;
+    bool read(istream &in); // false on truncated or malformed input
+};
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef RANK_TREE_HPP
+#define RANK_TREE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Order-statistic treap ordered by T::operator<, with subtree sizes for
+// O(log n) expected insert, rank and k-th queries. Nodes live in one vector
+// and link by index, so the tree costs no allocation per entry; erased nodes
+// are reused. Equal values keep insertion order.
+template <typename T>
+class RankTree
+{
+private:
+    struct Node
+    {
+        T value;
+        uint32_t priority; // max-heap ordered
+        int left;
+        int right;
+        size_t size;
+    };
+
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    int root;
+    uint64_t randomState;
+
+    size_t sizeOf(int node) const { return node < 0 ? 0 : nodes[node].size; }
+
+    void update(int node)
+    {
+        nodes[node].size = 1 + sizeOf(nodes[node].left) + sizeOf(nodes[node].right);
+    }
+
+    uint32_t nextPriority()
+    {
+        // xorshift64*
+        randomState ^= randomState >> 12;
+        randomState ^= randomState << 25;
+        randomState ^= randomState >> 27;
+        return (uint32_t)((randomState * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // left gets every value not after key (!(key < value)), right the rest
+    void split(int node, const T &key, int &left, int &right)
+    {
+        if (node < 0)
+        {
+            left = right = -1;
+            return;
+        }
+        if (key < nodes[node].value)
+        {
+            split(nodes[node].left, key, left, nodes[node].left);
+            right = node;
+        }
+        else
+        {
+            split(nodes[node].right, key, nodes[node].right, right);
+            left = node;
+        }
+        update(node);
+    }
+
+    // left gets the first count values, right the rest
+    void splitAt(int node, size_t count, int &left, int &right)
+    {
+        if (node < 0)
+        {
+            left = right = -1;
+            return;
+        }
+        size_t leftSize = sizeOf(nodes[node].left);
+        if (count <= leftSize)
+        {
+            splitAt(nodes[node].left, count, left, nodes[node].left);
+            right = node;
+        }
+        else
+        {
+            splitAt(nodes[node].right, count - leftSize - 1, nodes[node].right, right);
+            left = node;
+        }
+        update(node);
+    }
+
+    int merge(int left, int right)
+    {
+        if (left < 0)
+            return right;
+        if (right < 0)
+            return left;
+        if (nodes[left].priority > nodes[right].priority)
+        {
+            nodes[left].right = merge(nodes[left].right, right);
+            update(left);
+            return left;
+        }
+        nodes[right].left = merge(left, nodes[right].left);
+        update(right);
+        return right;
+    }
+
+    int buildBalanced(size_t first, size_t last) // nodes[first, last) are in order
+    {
+        if (first >= last)
+            return -1;
+        size_t middle = first + (last - first) / 2;
+        nodes[middle].left = buildBalanced(first, middle);
+        nodes[middle].right = buildBalanced(middle + 1, last);
+        update((int)middle);
+        return (int)middle;
+    }
+
+public:
+    RankTree() : root(-1), randomState(0x9E3779B97F4A7C15ull) {}
+
+    size_t size() const { return sizeOf(root); }
+
+    void clear()
+    {
+        nodes.clear();
+        freeNodes.clear();
+        root = -1;
+    }
+
+    // Replaces the contents with already sorted values in O(n log n) on
+    // integers only: a balanced shape, then random priorities handed out
+    // largest first in breadth-first order so the heap order holds.
+    void assignSorted(vector<T> &&sorted)
+    {
+        clear();
+        nodes.reserve(sorted.size());
+        for (T &value : sorted)
+            nodes.push_back({move(value), 0, -1, -1, 1});
+        root = buildBalanced(0, nodes.size());
+
+        vector<uint32_t> priorities(nodes.size());
+        for (uint32_t &priority : priorities)
+            priority = nextPriority();
+        sort(priorities.begin(), priorities.end(), greater<uint32_t>());
+
+        vector<int> level;
+        if (root >= 0)
+            level.push_back(root);
+        size_t next = 0;
+        for (size_t head = 0; head < level.size(); head++)
+        {
+            Node &node = nodes[level[head]];
+            node.priority = priorities[next++];
+            if (node.left >= 0)
+                level.push_back(node.left);
+            if (node.right >= 0)
+                level.push_back(node.right);
+        }
+    }
+
+    size_t insert(const T &value) // returns the 0-based position it landed at
+    {
+        int left, right;
+        split(root, value, left, right);
+        size_t position = sizeOf(left);
+
+        Node node = {value, nextPriority(), -1, -1, 1}; // copied first: value may live in nodes
+        int index;
+        if (freeNodes.empty())
+        {
+            index = (int)nodes.size();
+            nodes.push_back(move(node));
+        }
+        else
+        {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[index] = move(node);
+        }
+        root = merge(merge(left, index), right);
+        return position;
+    }
+
+    void eraseAt(size_t position) // position < size()
+    {
+        int left, middle, right;
+        splitAt(root, position, left, right);
+        splitAt(right, 1, middle, right);
+        nodes[middle].value = T();
+        freeNodes.push_back(middle);
+        root = merge(left, right);
+    }
+
+    size_t countBefore(const T &value) const // values strictly before value
+    {
+        size_t count = 0;
+        for (int node = root; node >= 0;)
+        {
+            if (nodes[node].value < value)
+            {
+                count += sizeOf(nodes[node].left) + 1;
+                node = nodes[node].right;
+            }
+            else
+            {
+                node = nodes[node].left;
+            }
+        }
+        return count;
+    }
+
+    const T &at(size_t position) const // position < size()
+    {
+        int node = root;
+        for (;;)
+        {
+            size_t leftSize = sizeOf(nodes[node].left);
+            if (position < leftSize)
+                node = nodes[node].left;
+            else if (position == leftSize)
+                return nodes[node].value;
+            else
+            {
+                position -= leftSize + 1;
+                node = nodes[node].right;
+            }
+        }
+    }
+
+    // Calls visit(value) in order until it returns false
+    template <typename Visitor>
+    void forEachWhile(Visitor visit) const
+    {
+        vector<int> path;
+        int node = root;
+        while (node >= 0 || !path.empty())
+        {
+            while (node >= 0)
+            {
+                path.push_back(node);
+                node = nodes[node].left;
+            }
+            node = path.back();
+            path.pop_back();
+            if (!visit(nodes[node].value))
+                return;
+            node = nodes[node].right;
+        }
+    }
+
+    // Calls visit(value) in order for the first limit values
+    template <typename Visitor>
+    void forEach(Visitor visit, size_t limit = SIZE_MAX) const
+    {
+        if (limit == 0)
+            return;
+        forEachWhile([&](const T &value)
+                     {
+                         visit(value);
+                         return --limit > 0; });
+    }
+};
+
+#endif
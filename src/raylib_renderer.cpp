@@ -30,7 +30,7 @@ void RaylibRenderer::drawTextEx(const char *text, float x, float y, float fontSi
     DrawTextEx(assets.gameFont, text, pos, fontSize, 1.0f, color);
 }
 
-std::string RaylibRenderer::formatMoney(long long amount) const
+std::string RaylibRenderer::formatCount(long long amount) const
 {
     std::string s = std::to_string(amount);
     int insertPosition = s.length() - 3;
@@ -39,7 +39,12 @@ std::string RaylibRenderer::formatMoney(long long amount) const
         s.insert(insertPosition, ",");
         insertPosition -= 3;
     }
-    return "$" + s;
+    return s;
+}
+
+std::string RaylibRenderer::formatMoney(long long amount) const
+{
+    return "$" + formatCount(amount);
 }
 
 void RaylibRenderer::handleTextInput(char *buffer, int &count, int max_length, int key, bool active)
@@ -438,7 +443,7 @@ void RaylibRenderer::drawLifelinePopup()
 void RaylibRenderer::drawAndHandleGameplay(Vector2 mousePos, bool mousePressed)
 {
     const Question &q = engine.getCurrentQuestion();
-    if (q.options.size() < 4) 
+    if (q.recordIndex < 0) 
     {
         drawCenteredText("Loading Question...", 200, 30, WHITE);
         return;
@@ -491,8 +496,8 @@ void RaylibRenderer::drawAndHandleGameplay(Vector2 mousePos, bool mousePressed)
     Rectangle qBoxRect = {qBoxX, qBoxY, qBoxWidth, qBoxHeight};
     DrawRectangleRounded(qBoxRect, 0.2f, 10, navyBlue);
     DrawRectangleLinesEx(qBoxRect, 3.0f, boxBorder);
-    float qTextW = measureTextSafe(assets.gameFont, q.text.c_str(), 35.0f, 1.0f);
-    drawTextEx(q.text.c_str(), qBoxX + (qBoxWidth - qTextW) / 2, qBoxY + (qBoxHeight / 2) - 17, 35.0f, WHITE);
+    float qTextW = measureTextSafe(assets.gameFont, q.text, 35.0f, 1.0f);
+    drawTextEx(q.text, qBoxX + (qBoxWidth - qTextW) / 2, qBoxY + (qBoxHeight / 2) - 17, 35.0f, WHITE);
 
     float optWidth = (vWidth * 0.4f); float optHeight = 80.0f;
     float gapX = vWidth * 0.05f; float gapY = 20.0f;
@@ -523,7 +528,7 @@ void RaylibRenderer::drawAndHandleGameplay(Vector2 mousePos, bool mousePressed)
         {
             controller.submitAnswer(i);
         }
-        string optText = ""; char prefix = 'A' + i; optText += prefix; optText += ": "; optText += q.options[i];
+        string optText = ""; char prefix = 'A' + i; optText += prefix; optText += ": "; optText += q.displayedOption(i);
         float optW = measureTextSafe(assets.gameFont, optText.c_str(), 30.0f, 1.0f);
         drawTextEx(optText.c_str(), optRects[i].x + (optWidth - optW) / 2, optRects[i].y + (optHeight / 2) - 15, 30.0f, WHITE);
     }
@@ -587,10 +592,22 @@ void RaylibRenderer::drawLeaderboard()
     float titleWidth = measureTextSafe(assets.gameFont, title, 80, 1.0f);
     DrawRectangle(virtualWidth / 2 - (titleWidth / 2), 140, titleWidth, 4, COL_GOLD);
 
-    Vector2 mouse = getVirtualMousePosition();
-    const auto &entries = engine.getLeaderboard().getTopEntries(8);
+    const int viewCount = LEADERBOARD_WINDOWS + 1;
+    static const char *viewNames[viewCount] = {"ALL TIME", "TODAY", "THIS WEEK", "THIS MONTH", "BEST PER PLAYER"};
+    if (IsKeyPressed(KEY_RIGHT)) leaderboardView = (leaderboardView + 1) % viewCount;
+    if (IsKeyPressed(KEY_LEFT)) leaderboardView = (leaderboardView + viewCount - 1) % viewCount;
+    string viewLabel = string("<  ") + viewNames[leaderboardView] + "  >";
+    drawCenteredText(viewLabel.c_str(), 150, 26, COL_TEXT_HINT);
 
-    if (entries.empty())
+    Vector2 mouse = getVirtualMousePosition();
+    // Pinned for the frame; games recorded meanwhile show up next frame
+    shared_ptr<const LeaderboardSnapshot> board = engine.getLeaderboard().getSnapshot();
+    const vector<LeaderboardEntry> &entries = leaderboardView == LEADERBOARD_WINDOWS
+                                                  ? board->players
+                                                  : board->getTop((LeaderboardWindow)leaderboardView);
+    size_t shown = min(entries.size(), (size_t)8);
+
+    if (shown == 0)
     {
         drawCenteredText("No Champions Yet... Be the First!", virtualHeight / 2, 40, COL_TEXT_HINT);
         if (IsKeyPressed(KEY_ENTER)) controller.clearPause();
@@ -640,9 +657,9 @@ void RaylibRenderer::drawLeaderboard()
     int r2W = cardBaseWidth * 0.9f; int r2X = r1X - cardGap - r2W;
     int r3W = cardBaseWidth * 0.9f; int r3X = r1X + r1W + cardGap;
 
-    if (entries.size() > 1) drawCard(entries[1], 2, r2X, cardY + 40, 0.9f);
-    if (entries.size() > 2) drawCard(entries[2], 3, r3X, cardY + 40, 0.9f);
-    if (entries.size() > 0) drawCard(entries[0], 1, r1X, cardY, 1.0f);
+    if (shown > 1) drawCard(entries[1], 2, r2X, cardY + 40, 0.9f);
+    if (shown > 2) drawCard(entries[2], 3, r3X, cardY + 40, 0.9f);
+    if (shown > 0) drawCard(entries[0], 1, r1X, cardY, 1.0f);
 
     int headerY = 580; int listY = headerY + 50; int rowHeight = 60; int rowW = 1200;
     int listX = (virtualWidth - rowW) / 2;
@@ -651,7 +668,7 @@ void RaylibRenderer::drawLeaderboard()
     int colQuestStart = listX + (rowW * 0.75f); int colQuestWidth = (rowW * 0.25f);
     int colQuestCenter = colQuestStart + (colQuestWidth / 2);
 
-    if (entries.size() > 3)
+    if (shown > 3)
     {
         Color headerCol = COL_GOLD; int headerSz = 32;
         drawTextEx("RANK", colRank, headerY, headerSz, headerCol);
@@ -663,7 +680,7 @@ void RaylibRenderer::drawLeaderboard()
         drawTextEx(qHeader, colQuestCenter - (qHeaderW / 2), headerY, headerSz, headerCol);
     }
 
-    for (size_t i = 3; i < entries.size(); i++)
+    for (size_t i = 3; i < shown; i++)
     {
         const auto &e = entries[i];
         Rectangle rowRect = {(float)listX, (float)listY, (float)rowW, (float)rowHeight};
@@ -681,6 +698,12 @@ void RaylibRenderer::drawLeaderboard()
         listY += (rowHeight + 10);
     }
 
+    const LeaderboardStats &stats = board->stats;
+    string statsLine = formatCount((long long)stats.totalGames) + " GAMES     " + formatMoney(stats.totalPrizePool) +
+                       " AWARDED     AVG LEVEL " + to_string(stats.getAverageLevel()) +
+                       "     MEDIAN " + formatMoney(stats.medianWinnings);
+    drawCenteredText(statsLine.c_str(), virtualHeight - 75, 24, COL_TEXT_HINT);
+
     if ((int)(GetTime() * 1.5) % 2 == 0)
         drawCenteredText("PRESS [ENTER] TO RETURN TO MENU", virtualHeight - 30, 30, WHITE);
     if (IsKeyPressed(KEY_ENTER)) controller.clearPause();
@@ -704,9 +727,9 @@ void RaylibRenderer::drawResultDisplay()
     {
         drawCenteredText("Better luck next time!", boxY + 120, 30, YELLOW);
         const Question &q = engine.getCurrentQuestion();
-        if (q.correctAnswerIndex >= 0 && q.correctAnswerIndex < q.options.size())
+        if (q.correctAnswerIndex >= 0 && q.correctAnswerIndex < 4)
         {
-            string correctAnswerText = "The correct answer was: " + q.options[q.correctAnswerIndex];
+            string correctAnswerText = string("The correct answer was: ") + q.options[q.correctAnswerIndex];
             drawCenteredText(correctAnswerText.c_str(), boxY + 220, 30, GREEN);
         }
     }
@@ -726,15 +749,17 @@ void RaylibRenderer::drawAndHandleFinalScore()
     string winningsText = "Total Winnings: " + formatMoney(p.totalWinnings);
     string levelText = "Final Level Reached: " + to_string(p.currentLevel);
     string correctText = "Questions answered correctly: " + to_string(p.questionsAnswered);
+    string rankText = "You placed #" + formatCount(engine.getFinalRank()) + " of " + formatCount(engine.getRankedGames()) + " games";
     int centerY = virtualHeight / 2; int spacing = 60;
 
     drawCenteredText("FINAL RESULTS", centerY - 100, 60, GOLD);
     drawCenteredText(winningsText.c_str(), centerY, 50, BLACK);
     drawCenteredText(levelText.c_str(), centerY + spacing, 50, BLACK);
     drawCenteredText(correctText.c_str(), centerY + spacing * 2, 50, BLACK);
+    if (engine.getRankedGames() > 0) drawCenteredText(rankText.c_str(), centerY + spacing * 3, 40, DARKBLUE);
 
     if (cachedQuote.empty()) cachedQuote = engine.getRandomQuote();
-    drawCenteredText(cachedQuote.c_str(), centerY + spacing * 3 + 20, 25, DARKGRAY);
+    drawCenteredText(cachedQuote.c_str(), centerY + spacing * 4 + 20, 25, DARKGRAY);
 
     float btnWidth = 300; float btnHeight = 60; float gap = 30;
     float startX = (virtualWidth - (btnWidth * 4) - (gap * 3)) / 2; float btnY = virtualHeight - 100;
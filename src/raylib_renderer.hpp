@@ -94,6 +94,8 @@ private:
 
     Rectangle lifelineRects[4];
 
+    int leaderboardView = 0; // a LeaderboardWindow, or LEADERBOARD_WINDOWS for one row per player; LEFT / RIGHT cycle
+
     std::string cachedQuote;
     std::string cachedResultText;
 
@@ -123,6 +125,7 @@ private:
     void drawCenteredText(const char *text, int y, int fontSize, Color color) const;
     void drawTextEx(const char *text, float x, float y, float fontSize, Color color) const;
 
+    std::string formatCount(long long amount) const; // digits grouped with commas
     std::string formatMoney(long long amount) const;
 
     void handleTextInput(char *buffer, int &count, int max_length, int key, bool active);
@@ -0,0 +1,185 @@
+#include "seen_history.hpp"
+#include "hashing.hpp"
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <array>
+#include <mutex>
+
+using namespace std;
+
+// Striped by path: loads run on the game thread's helper while finished games
+// are appended on the persistence worker, possibly for the same profile
+static mutex &fileLock(const string &path)
+{
+    static array<mutex, 64> locks;
+    return locks[fnv1a64(path) % locks.size()];
+}
+
+SeenHistory::SeenHistory(const string &historyDirectory) : directory(historyDirectory) {}
+
+string SeenHistory::pathFor(const string &name) const
+{
+    // Names can hold any character, so files are named by hash and sharded
+    // into 256 subdirectories to keep directories small at 100k+ profiles
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)fnv1a64(name));
+    return directory + "/" + string(hex, 2) + "/" + hex + ".seen";
+}
+
+bool SeenHistory::load(const string &name)
+{
+    profileName = name;
+    seen.clear();
+    unsaved.clear();
+
+    string path = pathFor(name);
+    lock_guard<mutex> lock(fileLock(path));
+    bool compact = false;
+    error_code ec;
+    if (filesystem::exists(path, ec) && !readFile(path, compact))
+    {
+        // Kept for inspection; the profile starts a fresh history so later
+        // appends land in a valid file
+        cerr << "Error: " << path << " is not a seen-question history for " << name << ", moved to " << path
+             << ".bad" << endl;
+        seen.clear();
+        filesystem::rename(path, path + ".bad", ec);
+        if (ec && !filesystem::remove(path, ec))
+            return false;
+    }
+
+    if (compact)
+        writeSnapshot(path);
+
+    if (!filesystem::exists(path, ec))
+    {
+        filesystem::create_directories(filesystem::path(path).parent_path(), ec);
+        if (!writeSnapshot(path))
+            return false;
+    }
+    return true;
+}
+
+bool SeenHistory::readFile(const string &path, bool &compact)
+{
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+        return false;
+
+    char magic[4];
+    uint32_t version, nameLength;
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(magic)) != 0 ||
+        !file.read(reinterpret_cast<char *>(&version), sizeof(version)) || version != VERSION ||
+        !file.read(reinterpret_cast<char *>(&nameLength), sizeof(nameLength)) || nameLength != profileName.size())
+        return false;
+
+    // The name guards against hash collisions between profiles
+    string storedName(nameLength, '\0');
+    if (!file.read(&storedName[0], nameLength) || storedName != profileName)
+        return false;
+
+    if (!seen.read(file))
+        return false;
+
+    // Appended IDs. Once they outgrow the snapshot, or a torn final write
+    // left a partial ID, the file is rewritten as a fresh snapshot.
+    int32_t id;
+    size_t tailCount = 0;
+    while (file.read(reinterpret_cast<char *>(&id), sizeof(id)))
+    {
+        seen.insert((uint32_t)id);
+        tailCount++;
+    }
+    compact = file.gcount() != 0 || (tailCount > 1024 && tailCount > seen.size() / 4);
+    return true;
+}
+
+bool SeenHistory::writeSnapshot(const string &path) const
+{
+    // Written beside the target and renamed over it, so a crash mid-write
+    // leaves the previous history intact
+    const string tempFile = path + ".tmp";
+    {
+        ofstream file(tempFile, ios::binary | ios::trunc);
+        if (!file.is_open())
+        {
+            cerr << "Error: Could not write " << path << endl;
+            return false;
+        }
+
+        uint32_t version = VERSION, nameLength = (uint32_t)profileName.size();
+        file.write(MAGIC, sizeof(MAGIC));
+        file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char *>(&nameLength), sizeof(nameLength));
+        file.write(profileName.data(), nameLength);
+        seen.write(file);
+        if (!file.good())
+        {
+            cerr << "Error: Could not write " << path << endl;
+            return false;
+        }
+    }
+
+    error_code ec;
+    filesystem::rename(tempFile, path, ec);
+    if (ec)
+    {
+        cerr << "Error: Could not write " << path << endl;
+        filesystem::remove(tempFile, ec);
+        return false;
+    }
+    return true;
+}
+
+void SeenHistory::record(int questionID)
+{
+    if (seen.insert((uint32_t)questionID))
+        unsaved.push_back(questionID);
+}
+
+bool SeenHistory::saveRecorded()
+{
+    if (unsaved.empty())
+        return true;
+    if (profileName.empty() || !appendRecorded(pathFor(profileName), unsaved))
+        return false;
+    unsaved.clear();
+    return true;
+}
+
+vector<int32_t> SeenHistory::takeRecorded()
+{
+    vector<int32_t> ids;
+    ids.swap(unsaved);
+    return ids;
+}
+
+bool SeenHistory::appendRecorded(const string &path, const vector<int32_t> &ids)
+{
+    if (ids.empty())
+        return true;
+
+    // load() creates the file with its header; appending to a missing one
+    // would leave a history without it
+    lock_guard<mutex> lock(fileLock(path));
+    error_code ec;
+    if (!filesystem::exists(path, ec))
+    {
+        cerr << "Error: " << path << " is missing, dropping " << ids.size() << " seen questions" << endl;
+        return false;
+    }
+    ofstream file(path, ios::binary | ios::app);
+    file.write(reinterpret_cast<const char *>(ids.data()), ids.size() * sizeof(int32_t));
+    file.close();
+    if (file.fail())
+    {
+        cerr << "Error: Could not write " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+const string &SeenHistory::getProfileName() const { return profileName; }
+
+const QuestionSet &SeenHistory::getSeen() const { return seen; }
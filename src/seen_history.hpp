@@ -0,0 +1,49 @@
+#ifndef SEEN_HISTORY_HPP
+#define SEEN_HISTORY_HPP
+
+#include "question_set.hpp"
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Question IDs a profile has been asked in earlier games. Every profile has
+// its own file under the history directory, so player_profiles.txt stays
+// small and only the current player's history is read, when their game
+// starts. A file is a compressed QuestionSet snapshot followed by the IDs
+// appended since; load() folds a long tail back into the snapshot.
+// IDs recorded during a game stay in memory and are appended in one write
+// when it ends, from whichever thread saves the game. File access is
+// serialized per profile, so a load never races an append to the same file.
+class SeenHistory
+{
+private:
+    static constexpr char MAGIC[4] = {'S', 'E', 'E', 'N'};
+    static constexpr uint32_t VERSION = 1;
+
+    string directory;
+    string profileName;
+    QuestionSet seen;        // IDs, as uint32
+    vector<int32_t> unsaved; // recorded since load or the last save
+    bool readFile(const string &path, bool &compact);
+    bool writeSnapshot(const string &path) const;
+
+public:
+    SeenHistory(const string &historyDirectory = "docs/seen");
+
+    // Switches profile; a missing file is an empty history, and a damaged
+    // one is moved aside to <path>.bad and started afresh
+    bool load(const string &name);
+    void record(int questionID);     // kept in memory until saved
+    bool saveRecorded();             // appends the recorded IDs to the profile's file
+    vector<int32_t> takeRecorded();  // or hands them to appendRecorded, for another thread
+    static bool appendRecorded(const string &path, const vector<int32_t> &ids);
+
+    string pathFor(const string &name) const;
+    const string &getProfileName() const;
+    const QuestionSet &getSeen() const;
+};
+
+#endif
@@ -0,0 +1,345 @@
+#include "session_manager.hpp"
+#include <random>
+#include <ctime>
+
+using namespace std;
+
+SessionManager::SessionManager() : replicator(leaderboard), persistence(leaderboard, profiles, replicator),
+                                   nextId(1), sessionCount(0)
+{
+}
+
+SessionManager::~SessionManager()
+{
+    shutdown();
+}
+
+bool SessionManager::initialize(const string &questionsFile, size_t pageCacheBytes)
+{
+    // Same loader as GameEngine: every session reads the snapshot current
+    // when it started, and reloads reach only sessions started afterwards
+    auto loadBank = [pageCacheBytes](QuestionBank &bank, const string &filename)
+    {
+        string pack = pageCacheBytes > 0 ? "" : QuestionBank::currentPackFor(filename);
+        if (pack.empty() || !bank.loadFromFile(pack))
+        {
+            LoadMode mode = pageCacheBytes > 0 ? LoadMode::PAGED : LoadMode::PARALLEL;
+            if (!bank.loadFromFile(filename, mode))
+                return false;
+        }
+        if (pageCacheBytes > 0)
+            bank.setPageCacheBudget(pageCacheBytes);
+        bank.loadCategoryMixes("docs/game_modes.txt");
+        return true;
+    };
+    return bankWatcher.start(questionsFile, loadBank);
+}
+
+bool SessionManager::startReplication(int port, const vector<string> &peers)
+{
+    return replicator.start(port, peers);
+}
+
+void SessionManager::shutdown()
+{
+    for (Shard &shard : shards)
+    {
+        unordered_map<uint64_t, shared_ptr<GameSession>> sessions;
+        {
+            lock_guard<mutex> lock(shard.lock);
+            sessions.swap(shard.sessions);
+        }
+        for (auto &item : sessions)
+        {
+            lock_guard<mutex> lock(item.second->lock);
+            if (item.second->active)
+                finish(*item.second);
+        }
+        sessionCount -= sessions.size();
+    }
+    persistence.flush();
+    replicator.stop();
+}
+
+shared_ptr<GameSession> SessionManager::find(uint64_t id)
+{
+    Shard &shard = shardOf(id);
+    lock_guard<mutex> lock(shard.lock);
+    auto it = shard.sessions.find(id);
+    return it == shard.sessions.end() ? nullptr : it->second;
+}
+
+const PrizeNode *SessionManager::rung(int level) const
+{
+    const PrizeNode *node = ladder.getHead();
+    while (node && node->next && node->level < level)
+        node = node->next;
+    return node;
+}
+
+uint64_t SessionManager::startSession(const string &name, const string &gender, const string &mode)
+{
+    shared_ptr<const QuestionBank> bank = bankWatcher.current();
+    if (!bank)
+        return 0;
+
+    auto session = make_shared<GameSession>();
+    session->id = nextId++;
+    session->player.name = name;
+    session->player.gender = gender;
+    session->gameMode = mode;
+    session->bank = bank;
+    session->awaitingAnswer = false;
+    session->winnings = 0;
+    session->streak = 0;
+    session->points = 0;
+    session->active = true;
+    session->finalRank = 0;
+    session->lastActive = (long long)time(nullptr);
+    profiles.getOrCreateProfile(name, gender);
+
+    // The history file is read here and appended to by the persistence
+    // worker when the game ends, so idle sessions hold no file handles
+    random_device device;
+    uint64_t seed = ((uint64_t)device() << 32) ^ session->id;
+    session->seenHistory.load(name);
+    bank->startSession(session->selection, seed, &session->seenHistory.getSeen());
+
+    Shard &shard = shardOf(session->id);
+    {
+        lock_guard<mutex> lock(shard.lock);
+        shard.sessions.emplace(session->id, session);
+    }
+    sessionCount++;
+    return session->id;
+}
+
+bool SessionManager::nextQuestion(uint64_t id, Question &question)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return false;
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active)
+        return false;
+    session->lastActive = (long long)time(nullptr);
+
+    // A client that reconnects gets the same question, with its clock running
+    if (!session->awaitingAnswer)
+    {
+        int difficulty = session->lifelines.getNextDifficulty(session->player.currentLevel);
+        session->currentQuestion = session->bank->selectQuestion(session->selection, difficulty, session->gameMode);
+        if (session->currentQuestion.id == -1)
+        {
+            finish(*session);
+            return false;
+        }
+        session->player.recordQuestion(session->currentQuestion.recordIndex);
+        session->seenHistory.record(session->currentQuestion.id);
+        session->timer.setDuration(session->lifelines.getTimeLimit(difficulty));
+        session->timer.start();
+        session->awaitingAnswer = true;
+    }
+    question = session->currentQuestion;
+    return true;
+}
+
+AnswerOutcome SessionManager::answer(uint64_t id, int optionIndex)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return AnswerOutcome::NO_QUESTION;
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active || !session->awaitingAnswer)
+        return AnswerOutcome::NO_QUESTION;
+    session->lastActive = (long long)time(nullptr);
+    session->awaitingAnswer = false;
+
+    // Out of time ends the game with what was already won, as in the kiosk
+    if (session->timer.isFinished())
+    {
+        finish(*session);
+        return AnswerOutcome::TIMED_OUT;
+    }
+
+    Player &player = session->player;
+    const Question &question = session->currentQuestion;
+    bool isCorrect = session->bank->isCorrectAnswer(question.id, optionIndex, question.optionOrder);
+    session->answerLog.push_back({question.category, isCorrect});
+
+    if (!isCorrect)
+    {
+        // Back down to the last safety level, unless standing on one
+        const PrizeNode *node = rung(player.currentLevel);
+        while (node->prev && !node->isSafetyLevel)
+            node = node->prev;
+        session->streak = 0;
+        session->winnings = node->prizeAmount;
+        player.totalWinnings = session->winnings;
+        finish(*session);
+        return AnswerOutcome::WRONG;
+    }
+
+    session->streak++;
+    session->points += session->lifelines.calculatePoints(player.currentLevel,
+                                                          session->lifelines.getNextDifficulty(player.currentLevel));
+    session->points += session->lifelines.getStreakBonus(session->streak);
+
+    const PrizeNode *node = rung(player.currentLevel + 1);
+    player.currentLevel = node->level;
+    player.totalWinnings = session->winnings = node->prizeAmount;
+    player.questionsAnswered++;
+    if (!node->next)
+    {
+        finish(*session);
+        return AnswerOutcome::WON;
+    }
+    return AnswerOutcome::CORRECT;
+}
+
+vector<int> SessionManager::use50_50Lifeline(uint64_t id)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return {};
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active || !session->awaitingAnswer || !session->lifelines.isLifelineAvailable(0))
+        return {};
+    session->player.lifelinesUsed[0] = 1;
+    return session->lifelines.apply50_50Lifeline(session->currentQuestion);
+}
+
+int SessionManager::useAskFriendLifeline(uint64_t id)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return -1;
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active || !session->awaitingAnswer || !session->lifelines.isLifelineAvailable(1))
+        return -1;
+    session->player.lifelinesUsed[1] = 1;
+    return session->lifelines.applyAskFriendLifeline(session->currentQuestion);
+}
+
+bool SessionManager::useSkipLifeline(uint64_t id)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return false;
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active || !session->awaitingAnswer || !session->lifelines.applySkipLifeline())
+        return false;
+    session->player.lifelinesUsed[2] = 1;
+    session->awaitingAnswer = false;
+    session->timer.stop();
+    return true;
+}
+
+string SessionManager::useHintLifeline(uint64_t id)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return "";
+    lock_guard<mutex> lock(session->lock);
+    if (!session->active || !session->awaitingAnswer || !session->lifelines.isLifelineAvailable(3))
+        return "";
+    session->player.lifelinesUsed[3] = 1;
+    return session->lifelines.applyHintLifeline(session->currentQuestion);
+}
+
+bool SessionManager::getStatus(uint64_t id, SessionStatus &status)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return false;
+    lock_guard<mutex> lock(session->lock);
+    status.playerName = session->player.name;
+    status.level = session->player.currentLevel;
+    status.winnings = session->winnings;
+    status.points = session->points;
+    status.streak = session->streak;
+    status.questionsAnswered = session->player.questionsAnswered;
+    status.remainingSeconds = session->awaitingAnswer ? session->timer.getRemainingSeconds() : 0;
+    status.active = session->active;
+    status.finalRank = session->finalRank;
+    return true;
+}
+
+void SessionManager::finish(GameSession &session)
+{
+    session.active = false;
+    session.awaitingAnswer = false;
+    session.timer.stop();
+
+    const Player &player = session.player;
+    long long now = (long long)time(nullptr);
+    LeaderboardEntry entry = {player.name, player.totalWinnings, player.currentLevel, player.questionsAnswered, now};
+    session.finalRank = leaderboard.getRank(entry);
+
+    persistence.submit({player.name,
+                        player.totalWinnings,
+                        player.currentLevel,
+                        player.questionsAnswered,
+                        now,
+                        move(session.answerLog),
+                        session.seenHistory.pathFor(player.name),
+                        session.seenHistory.takeRecorded()});
+    session.answerLog.clear();
+}
+
+bool SessionManager::endSession(uint64_t id)
+{
+    shared_ptr<GameSession> session = find(id);
+    if (!session)
+        return false;
+    {
+        lock_guard<mutex> lock(session->lock);
+        if (session->active)
+            finish(*session);
+    }
+
+    Shard &shard = shardOf(id);
+    lock_guard<mutex> lock(shard.lock);
+    if (shard.sessions.erase(id) == 0)
+        return false; // ended by another thread meanwhile
+    sessionCount--;
+    return true;
+}
+
+size_t SessionManager::closeIdleSessions(int idleSeconds)
+{
+    long long cutoff = (long long)time(nullptr) - idleSeconds;
+    size_t closed = 0;
+    for (Shard &shard : shards)
+    {
+        vector<shared_ptr<GameSession>> idle;
+        {
+            lock_guard<mutex> lock(shard.lock);
+            for (auto &item : shard.sessions)
+                idle.push_back(item.second);
+        }
+
+        // Checked under each session's own lock, so a request that lands
+        // meanwhile keeps its session
+        for (shared_ptr<GameSession> &session : idle)
+        {
+            lock_guard<mutex> lock(session->lock);
+            if (session->lastActive > cutoff)
+                continue;
+            if (session->active)
+                finish(*session);
+            lock_guard<mutex> shardLock(shard.lock);
+            if (shard.sessions.erase(session->id) > 0)
+            {
+                sessionCount--;
+                closed++;
+            }
+        }
+    }
+    return closed;
+}
+
+size_t SessionManager::getSessionCount() const { return sessionCount; }
+
+Leaderboard &SessionManager::getLeaderboard() { return leaderboard; }
+PlayerProfileManager &SessionManager::getProfileManager() { return profiles; }
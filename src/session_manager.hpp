@@ -0,0 +1,133 @@
+#ifndef SESSION_MANAGER_HPP
+#define SESSION_MANAGER_HPP
+
+#include "data_structures.hpp"
+#include "question_bank.hpp"
+#include "question_bank_watcher.hpp"
+#include "leaderboard.hpp"
+#include "leaderboard_replicator.hpp"
+#include "game_logic.hpp"
+#include "timer.hpp"
+#include "player_profile.hpp"
+#include "seen_history.hpp"
+#include "persistence_worker.hpp"
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+// Everything one game needs that differs from player to player. The prize
+// ladder, question bank and services live once in the SessionManager.
+struct GameSession
+{
+    mutex lock; // one request at a time per session
+    uint64_t id;
+    Player player;
+    string gameMode;
+    GameLogic lifelines;                 // lifeline state and scoring rules
+    shared_ptr<const QuestionBank> bank; // snapshot this game started with
+    SelectionState selection;
+    SeenHistory seenHistory; // read at start, appended by the persistence worker at the end
+    Question currentQuestion;
+    bool awaitingAnswer;
+    GameTimer timer;
+    long long winnings; // what the game is worth if it ends now
+    int streak;
+    int points;
+    bool active;
+    int finalRank;
+    vector<pair<int, bool>> answerLog;
+    long long lastActive; // unix seconds
+};
+
+enum class AnswerOutcome
+{
+    CORRECT,
+    WRONG,     // game over at the last safety level
+    TIMED_OUT, // game over keeping what was won
+    WON,       // top of the ladder
+    NO_QUESTION // unknown or finished session, or no question pending
+};
+
+// What a client can show between requests
+struct SessionStatus
+{
+    string playerName;
+    int level;
+    long long winnings;
+    int points;
+    int streak;
+    int questionsAnswered;
+    int remainingSeconds; // on the current question
+    bool active;
+    int finalRank;        // once the game is over
+};
+
+// Runs many games at once in one process (classrooms, events), each driven
+// by its own client through a session id. Sessions are small and share one
+// bank snapshot, prize ladder, leaderboard and profile store; requests for
+// different sessions run in parallel from any number of threads, with
+// sessions spread over independently locked shards. Finished games go
+// through the same persistence worker as the kiosk game.
+// wwtbam-sessions hosts one over TCP. A process runs either this or a
+// GameEngine, as both own the docs/ files.
+class SessionManager
+{
+private:
+    static constexpr size_t SHARDS = 64;
+
+    struct Shard
+    {
+        mutex lock;
+        unordered_map<uint64_t, shared_ptr<GameSession>> sessions;
+    };
+
+    QuestionBankWatcher bankWatcher;
+    const PrizeLadder ladder; // read only, shared by every session
+    Leaderboard leaderboard;
+    LeaderboardReplicator replicator;
+    PlayerProfileManager profiles;
+    PersistenceWorker persistence;
+    array<Shard, SHARDS> shards;
+    atomic<uint64_t> nextId;
+    atomic<size_t> sessionCount;
+
+    Shard &shardOf(uint64_t id) { return shards[id % SHARDS]; }
+    shared_ptr<GameSession> find(uint64_t id);
+    const PrizeNode *rung(int level) const;
+    void finish(GameSession &session); // caller holds session.lock
+
+public:
+    SessionManager();
+    ~SessionManager();
+
+    SessionManager(const SessionManager &) = delete;
+    SessionManager &operator=(const SessionManager &) = delete;
+
+    bool initialize(const string &questionsFile, size_t pageCacheBytes = 0);
+    bool startReplication(int port, const vector<string> &peers);
+    void shutdown(); // ends every session and writes out what is queued
+
+    uint64_t startSession(const string &name, const string &gender, const string &mode = "classic"); // 0 if not initialized
+    bool nextQuestion(uint64_t id, Question &question); // the pending one again if unanswered; false when the game is over
+    AnswerOutcome answer(uint64_t id, int optionIndex); // as displayed
+    vector<int> use50_50Lifeline(uint64_t id);
+    int useAskFriendLifeline(uint64_t id);
+    bool useSkipLifeline(uint64_t id); // the next nextQuestion draws a new question
+    string useHintLifeline(uint64_t id);
+    bool getStatus(uint64_t id, SessionStatus &status);
+    bool endSession(uint64_t id);              // walks away with what was won, and forgets the session
+    size_t closeIdleSessions(int idleSeconds); // clients that went away; returns how many
+    size_t getSessionCount() const;
+
+    Leaderboard &getLeaderboard();
+    PlayerProfileManager &getProfileManager();
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "leaderboard.hpp"
+#include "leaderboard_history.hpp"
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+// Boards at past moments must match a brute-force replay of every game,
+// with runs archived into the history file, after reopening it, and after
+// deleting it so the first query rebuilds it from the segments. Games arrive
+// out of timestamp order, and their scores trend upwards so the board
+// changes often enough to cross several checkpoints.
+
+static const int GAMES = 75000; // two MEMTABLE_LIMITs archived, the rest recent
+static const int SAVE_EVERY = 500;
+static const int QUERIES = 300;
+
+static bool placedBefore(const LeaderboardEntry &a, const LeaderboardEntry &b)
+{
+    if (a < b)
+        return true;
+    return !(b < a) && a.timestamp < b.timestamp;
+}
+
+static vector<LeaderboardEntry> bruteForceAt(const vector<LeaderboardEntry> &games, long long timestamp, size_t count)
+{
+    vector<LeaderboardEntry> board;
+    for (const LeaderboardEntry &game : games)
+    {
+        if (game.timestamp <= timestamp)
+            board.push_back(game);
+    }
+    size_t kept = min(count, board.size());
+    partial_sort(board.begin(), board.begin() + kept, board.end(), placedBefore);
+    board.resize(kept);
+    return board;
+}
+
+// Names may tie on every other field, so only the placing is compared
+static bool sameBoard(const vector<LeaderboardEntry> &a, const vector<LeaderboardEntry> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (make_tuple(a[i].winnings, a[i].level, a[i].timestamp) != make_tuple(b[i].winnings, b[i].level, b[i].timestamp))
+            return false;
+    }
+    return true;
+}
+
+static int checkBoards(const string &label, const Leaderboard &leaderboard, const vector<LeaderboardEntry> &games,
+                       long long first, long long last)
+{
+    mt19937 rng(3);
+    int failures = 0;
+    for (int i = 0; i < QUERIES; i++)
+    {
+        long long moment = first - 10 + (long long)(rng() % (uint64_t)(last - first + 20));
+        size_t count = i % 3 == 0 ? LeaderboardHistory::DEPTH : Leaderboard::SNAPSHOT_SIZE;
+        if (!sameBoard(leaderboard.getTopAt(moment, (int)count), bruteForceAt(games, moment, count)))
+        {
+            if (failures == 0)
+                cerr << label << ": board at " << moment << " differs" << endl;
+            failures++;
+        }
+    }
+    cout << label << ": " << QUERIES - failures << "/" << QUERIES << " boards match\n";
+    return failures;
+}
+
+int main()
+{
+    // The leaderboard works in docs/ under the current directory
+    filesystem::path scratch = filesystem::temp_directory_path() / "wwtbam_test_leaderboard_history";
+    error_code ec;
+    filesystem::remove_all(scratch, ec);
+    filesystem::create_directories(scratch / "docs");
+    filesystem::current_path(scratch);
+    const string historyFile = "docs/leaderboard_archive/history.lbh";
+
+    mt19937 rng(1);
+    const long long start = 1700000000;
+    vector<LeaderboardEntry> games;
+    for (int i = 0; i < GAMES; i++)
+    {
+        int level = (int)(rng() % 16);
+        long long played = start + (long long)i * 10 - (long long)(rng() % 5000);
+        long long winnings = i % 2 ? (long long)(rng() % 1000000) : (long long)i * 20 + (long long)(rng() % 200000);
+        games.push_back({"player" + to_string(rng() % 5000), winnings, level, level, played});
+    }
+    long long first = start - 5000, last = start + (long long)GAMES * 10;
+
+    int failures = 0;
+    {
+        Leaderboard leaderboard;
+        for (int i = 0; i < GAMES; i++)
+        {
+            leaderboard.addEntry(games[i]);
+            if (i % SAVE_EVERY == SAVE_EVERY - 1)
+                leaderboard.saveToFile();
+        }
+        leaderboard.saveToFile();
+        failures += checkBoards("live", leaderboard, games, first, last);
+    }
+    if (!filesystem::exists(historyFile))
+    {
+        cerr << "No history file was written while archiving" << endl;
+        failures++;
+    }
+    {
+        Leaderboard leaderboard;
+        failures += checkBoards("reopened", leaderboard, games, first, last);
+    }
+    filesystem::remove(historyFile, ec);
+    {
+        Leaderboard leaderboard;
+        failures += checkBoards("rebuilt", leaderboard, games, first, last);
+    }
+
+    filesystem::current_path(scratch.parent_path());
+    filesystem::remove_all(scratch, ec);
+    cout << (failures == 0 ? "PASS" : "FAIL") << "\n";
+    return failures == 0 ? 0 : 1;
+}
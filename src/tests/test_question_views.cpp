@@ -0,0 +1,98 @@
+#include "question_bank.hpp"
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+
+using namespace std;
+
+// Questions are views into the bank: serving and copying them must not
+// allocate, for resident and pack loads, and for paged loads once a page
+// is cached.
+
+static atomic<long long> allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *block = malloc(size ? size : 1))
+        return block;
+    throw bad_alloc();
+}
+
+void operator delete(void *block) noexcept { free(block); }
+void operator delete(void *block, size_t) noexcept { free(block); }
+
+static bool writeBank(const string &filename, int count)
+{
+    ofstream file(filename, ios::trunc);
+    for (int i = 1; i <= count; i++)
+        file << i << "|" << 1 + i % 5 << "|Question " << i << " text?|Option A " << i
+             << "|Option B|Option C|Option D|" << i % 4 << "|Hint " << i << "|" << 1 + i % 3 << "\n";
+    file.close();
+    return !file.fail();
+}
+
+// Serves every record, copying each question twice, and returns the number
+// of allocations made while doing so
+static long long serveAll(const QuestionBank &bank, size_t &checksum)
+{
+    long long before = allocations;
+    Question current;
+    for (int i = 0; i < bank.getTotalQuestions(); i++)
+    {
+        Question served = bank.getQuestion(i, (unsigned char)(i % 24));
+        current = served;
+        Question copy(current);
+        checksum += copy.text[0] + copy.displayedOption(0)[0] + copy.hint[0];
+    }
+    return allocations - before;
+}
+
+static int check(const string &label, long long counted)
+{
+    cout << label << ": " << counted << " allocations\n";
+    return counted == 0 ? 0 : 1;
+}
+
+int main()
+{
+    const string textFile = "test_question_views.txt";
+    const string packFile = "test_question_views.qpack";
+    const int COUNT = 2000;
+    if (!writeBank(textFile, COUNT))
+    {
+        cerr << "Could not write " << textFile << endl;
+        return 1;
+    }
+
+    int failures = 0;
+    size_t checksum = 0;
+    {
+        QuestionBank bank;
+        if (!bank.loadFromFile(textFile) || bank.getTotalQuestions() != COUNT || !bank.saveToPack(packFile))
+            return 1;
+        failures += check("resident", serveAll(bank, checksum));
+    }
+    {
+        QuestionBank bank;
+        if (!bank.loadFromFile(packFile))
+            return 1;
+        failures += check("pack", serveAll(bank, checksum));
+    }
+    {
+        QuestionBank bank;
+        if (!bank.loadFromFile(textFile, LoadMode::PAGED))
+            return 1;
+        bank.setPageCacheBudget(64 << 20);
+        serveAll(bank, checksum); // fills the cache
+        failures += check("paged, cached", serveAll(bank, checksum));
+    }
+
+    remove(textFile.c_str());
+    remove(packFile.c_str());
+    cout << (failures == 0 ? "PASS" : "FAIL") << " (checksum " << checksum << ")\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#include "leaderboard.hpp"
+#include "leaderboard_replicator.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Two instances in separate processes, each beside its own docs directory,
+// must hold the same board through crashes:
+//  1. both play games and sync
+//  2. A crashes after logging a game but before saving it to its board, and
+//     B's log ends in a torn line, as a power cut mid-append leaves it
+//  3. both restart, play another game each and sync again
+// Afterwards both boards hold every game exactly once, and B carries on
+// under a new instance id.
+
+static const int WAIT_SECONDS = 30;
+
+static LeaderboardEntry game(const string &name, int level)
+{
+    return {name, (long long)level * 1000, level, level, 1700000000 + level};
+}
+
+static bool waitFor(const function<bool()> &done)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(WAIT_SECONDS);
+    while (!done())
+    {
+        if (chrono::steady_clock::now() > deadline)
+            return false;
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    return true;
+}
+
+// One instance's run, in a child process. Games are published, then saved,
+// as the persistence worker does; crash stops it between the two for the
+// last one. Otherwise it waits until it holds total games, says so, and
+// stops when the parent says.
+static int runInstance(const filesystem::path &dir, int port, int peerPort, const vector<LeaderboardEntry> &games,
+                       int total, bool crash)
+{
+    filesystem::current_path(dir);
+    Leaderboard leaderboard;
+    LeaderboardReplicator replicator(leaderboard);
+    if (!replicator.start(port, {"127.0.0.1:" + to_string(peerPort)}))
+        return 1;
+    ofstream("instance.txt") << replicator.getInstanceId() << "\n";
+
+    for (size_t i = 0; i < games.size(); i++)
+    {
+        replicator.publish({games[i]});
+        if (crash && i + 1 == games.size())
+            _exit(0);
+        leaderboard.addEntry(games[i]);
+        leaderboard.saveToFile();
+    }
+
+    bool synced = waitFor([&]
+                          { return leaderboard.getTotalGames() == total; });
+    if (synced)
+        ofstream("synced");
+    waitFor([]
+            { return filesystem::exists("../stop"); });
+    replicator.stop();
+    if (!synced)
+        cerr << dir.filename().string() << " holds " << leaderboard.getTotalGames() << " of " << total << " games" << endl;
+    return synced ? 0 : 1;
+}
+
+static pid_t spawn(const function<int()> &run)
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        int status = run();
+        cout.flush();
+        cerr.flush();
+        _exit(status);
+    }
+    return child;
+}
+
+static bool succeeded(pid_t child)
+{
+    int status = 0;
+    return child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Both instances until each holds total games; false if either fails
+static bool playRound(const filesystem::path &scratch, int portA, int portB, const vector<LeaderboardEntry> &gamesA,
+                      const vector<LeaderboardEntry> &gamesB, int total)
+{
+    error_code ec;
+    for (const char *marker : {"stop", "a/synced", "b/synced"})
+        filesystem::remove(scratch / marker, ec);
+    pid_t a = spawn([&]
+                    { return runInstance(scratch / "a", portA, portB, gamesA, total, false); });
+    pid_t b = spawn([&]
+                    { return runInstance(scratch / "b", portB, portA, gamesB, total, false); });
+    waitFor([&]
+            { return filesystem::exists(scratch / "a/synced") && filesystem::exists(scratch / "b/synced"); });
+    ofstream(scratch / "stop");
+    bool okA = succeeded(a), okB = succeeded(b);
+    return okA && okB;
+}
+
+// Sorted, so boards compare whatever order games were saved in
+static vector<string> readLines(const filesystem::path &file)
+{
+    vector<string> lines;
+    ifstream in(file);
+    string line;
+    while (getline(in, line))
+        lines.push_back(line);
+    sort(lines.begin(), lines.end());
+    return lines;
+}
+
+int main()
+{
+    filesystem::path scratch = filesystem::temp_directory_path() / ("wwtbam_test_replication_" + to_string(getpid()));
+    error_code ec;
+    filesystem::remove_all(scratch, ec);
+    filesystem::create_directories(scratch / "a/docs");
+    filesystem::create_directories(scratch / "b/docs");
+    int portA = 20000 + getpid() % 20000, portB = portA + 1;
+
+    int failures = 0;
+    if (!playRound(scratch, portA, portB, {game("ann", 1), game("ann", 2), game("al", 3)},
+                   {game("bea", 4), game("bo", 5)}, 5))
+    {
+        cerr << "First round did not converge" << endl;
+        failures++;
+    }
+    vector<string> idsB = readLines(scratch / "b/instance.txt");
+    string firstIdB = idsB.empty() ? "" : idsB[0];
+
+    // A logs a game and dies before its board has it
+    pid_t crashed = spawn([&]
+                          { return runInstance(scratch / "a", portA, portB, {game("ann", 6)}, 0, true); });
+    if (!succeeded(crashed))
+        failures++;
+    // B's last append was cut short
+    ofstream(scratch / "b/docs/replication.log", ios::app) << firstIdB << "|3|bo|7000|7|7";
+
+    if (!playRound(scratch, portA, portB, {game("al", 8)}, {game("bea", 9)}, 8))
+    {
+        cerr << "Second round did not converge" << endl;
+        failures++;
+    }
+
+    vector<string> boardA = readLines(scratch / "a/docs/leaderboard.txt");
+    vector<string> boardB = readLines(scratch / "b/docs/leaderboard.txt");
+    if (boardA.size() != 8 || boardA != boardB)
+    {
+        cerr << "Boards differ: A holds " << boardA.size() << " games, B " << boardB.size() << endl;
+        failures++;
+    }
+    if (readLines(scratch / "b/instance.txt") == idsB)
+    {
+        cerr << "B kept its instance id after losing the tail of its log" << endl;
+        failures++;
+    }
+
+    filesystem::remove_all(scratch, ec);
+    cout << (failures == 0 ? "PASS" : "FAIL") << "\n";
+    return failures == 0 ? 0 : 1;
+}
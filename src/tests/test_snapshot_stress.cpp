@@ -0,0 +1,93 @@
+#include "leaderboard.hpp"
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Readers load snapshots while one writer adds games and saves, crossing
+// the archive threshold. Every reader must see versions and game counts
+// that never go backwards, and boards that are sorted and within size.
+// Build with -fsanitize=thread to check the publication itself.
+
+static const int READERS = 4;
+static const int GAMES = 80000; // over two MEMTABLE_LIMITs, so runs are archived
+static const int SAVE_EVERY = 500;
+
+static bool sortedBoard(const vector<LeaderboardEntry> &board)
+{
+    if (board.size() > Leaderboard::SNAPSHOT_SIZE)
+        return false;
+    for (size_t i = 1; i < board.size(); i++)
+        if (board[i] < board[i - 1])
+            return false;
+    return true;
+}
+
+int main()
+{
+    // The leaderboard works in docs/ under the current directory
+    filesystem::path scratch = filesystem::temp_directory_path() / "wwtbam_test_snapshot_stress";
+    error_code ec;
+    filesystem::remove_all(scratch, ec);
+    filesystem::create_directories(scratch / "docs");
+    filesystem::current_path(scratch);
+
+    atomic<bool> writing(true);
+    atomic<long long> failures(0), reads(0);
+    {
+        Leaderboard leaderboard;
+
+        vector<thread> readers;
+        for (int r = 0; r < READERS; r++)
+            readers.emplace_back([&]
+                                 {
+                uint64_t lastVersion = 0;
+                size_t lastGames = 0;
+                while (writing)
+                {
+                    shared_ptr<const LeaderboardSnapshot> snapshot = leaderboard.getSnapshot();
+                    bool ok = snapshot->version >= lastVersion && snapshot->stats.totalGames >= lastGames &&
+                              sortedBoard(snapshot->players);
+                    for (int window = 0; window < LEADERBOARD_WINDOWS; window++)
+                        ok = ok && sortedBoard(snapshot->top[window]);
+                    if (!ok)
+                        failures++;
+                    lastVersion = snapshot->version;
+                    lastGames = snapshot->stats.totalGames;
+                    reads++;
+                    this_thread::yield();
+                } });
+
+        mt19937 rng(1);
+        long long now = (long long)time(nullptr);
+        for (int i = 0; i < GAMES; i++)
+        {
+            int level = (int)(rng() % 16);
+            leaderboard.addEntry({"player" + to_string(rng() % 5000), (long long)(rng() % 1000000), level, level,
+                                  now - (long long)(rng() % (40 * Leaderboard::SECONDS_PER_DAY))});
+            if (i % SAVE_EVERY == SAVE_EVERY - 1)
+                leaderboard.saveToFile();
+        }
+        leaderboard.saveToFile();
+        writing = false;
+        for (thread &reader : readers)
+            reader.join();
+
+        size_t total = leaderboard.getSnapshot()->stats.totalGames;
+        if (total != (size_t)GAMES)
+        {
+            cerr << "Final snapshot counts " << total << " games, expected " << GAMES << endl;
+            failures++;
+        }
+    }
+
+    filesystem::current_path(scratch.parent_path());
+    filesystem::remove_all(scratch, ec);
+    cout << reads << " snapshot reads, " << failures << " failures\n";
+    cout << (failures == 0 ? "PASS" : "FAIL") << "\n";
+    return failures == 0 ? 0 : 1;
+}
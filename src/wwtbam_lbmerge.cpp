@@ -0,0 +1,289 @@
+#include <iostream>
+#include <queue>
+#include <chrono>
+#include <cctype>
+#include <filesystem>
+#include "leaderboard.hpp"
+#include "leaderboard_segment.hpp"
+#include "merge_sort.hpp"
+
+using namespace std;
+
+// Streams the next entry of one sorted input; false at the end
+using Run = function<bool(LeaderboardEntry &)>;
+
+static Run segmentRun(const string &path, size_t &games)
+{
+    auto segment = make_shared<LeaderboardSegment>();
+    if (!segment->open(path))
+    {
+        cerr << "Error: Unable to read leaderboard segment " << path << "\n";
+        return nullptr;
+    }
+    games += segment->size();
+    auto position = make_shared<size_t>(0);
+    return [segment, position](LeaderboardEntry &entry)
+    {
+        if (*position == segment->size())
+            return false;
+        entry = segment->at((*position)++);
+        return true;
+    };
+}
+
+// Sorted text files stream in constant memory. Kiosk logs are unsorted
+// appends, but a log only holds the games since the kiosk last archived,
+// so those are sorted in memory.
+static Run textRun(const string &path, size_t &games)
+{
+    ifstream check(path);
+    if (!check.is_open())
+    {
+        cerr << "Error: Unable to open " << path << "\n";
+        return nullptr;
+    }
+    bool sorted = true;
+    size_t checked = 0;
+    LeaderboardEntry previous, entry;
+    bool first = true;
+    string line;
+    while (sorted && getline(check, line))
+    {
+        if (!Leaderboard::parseEntry(line, entry))
+            continue;
+        checked++;
+        sorted = first || !(entry < previous);
+        previous = move(entry);
+        first = false;
+    }
+    check.close();
+
+    if (!sorted)
+    {
+        auto loaded = make_shared<vector<LeaderboardEntry>>();
+        ifstream in(path);
+        while (getline(in, line))
+        {
+            if (Leaderboard::parseEntry(line, entry))
+                loaded->push_back(entry);
+        }
+        games += loaded->size();
+        MergeSorter<LeaderboardEntry>::sort(*loaded);
+        auto position = make_shared<size_t>(0);
+        return [loaded, position](LeaderboardEntry &next)
+        {
+            if (*position == loaded->size())
+                return false;
+            next = move((*loaded)[(*position)++]);
+            return true;
+        };
+    }
+
+    games += checked;
+    auto in = make_shared<ifstream>(path);
+    return [in](LeaderboardEntry &next)
+    {
+        string text;
+        while (getline(*in, text))
+        {
+            if (Leaderboard::parseEntry(text, next))
+                return true;
+        }
+        return false;
+    };
+}
+
+// leaderboard.txt.<seq>, as the game names logs it rotates out
+static bool isRotatedLog(const string &name)
+{
+    const string prefix = "leaderboard.txt.";
+    return name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+           name.find_first_not_of("0123456789", prefix.size()) == string::npos;
+}
+
+// A kiosk's docs directory: its archived segments, its live log and any
+// log rotated out for a flush that had not finished
+static bool addKiosk(const filesystem::path &dir, vector<Run> &runs, size_t &games)
+{
+    error_code ec;
+    for (const auto &file : filesystem::directory_iterator(dir / "leaderboard_archive", ec))
+    {
+        if (file.path().extension() == ".lbs")
+            runs.push_back(segmentRun(file.path().string(), games));
+    }
+    for (const auto &file : filesystem::directory_iterator(dir, ec))
+    {
+        string name = file.path().filename().string();
+        if (name == "leaderboard.txt" || isRotatedLog(name))
+            runs.push_back(textRun(file.path().string(), games));
+    }
+    return !ec;
+}
+
+// Players type their names at each kiosk; case and surrounding spaces don't
+// make a different player
+static string identityOf(const string &name)
+{
+    size_t first = name.find_first_not_of(" \t");
+    size_t last = name.find_last_not_of(" \t");
+    string key = first == string::npos ? "" : name.substr(first, last - first + 1);
+    for (char &c : key)
+        c = (char)tolower((unsigned char)c);
+    return key;
+}
+
+// Offline merge: many kiosks' leaderboards -> one docs directory the game loads
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: wwtbam-lbmerge <output docs dir> <kiosk docs dir | leaderboard.txt | segment.lbs>...\n";
+        return 1;
+    }
+
+    filesystem::path output = argv[1];
+    filesystem::path archive = output / "leaderboard_archive";
+    error_code ec;
+    if (filesystem::exists(archive, ec) && !filesystem::is_empty(archive, ec))
+    {
+        cerr << "Error: " << archive.string() << " already holds a leaderboard\n";
+        return 1;
+    }
+
+    // The output's logs are replaced by the merge, so games in them must be
+    // among the inputs: its own docs dir, or its live log with nothing rotated
+    filesystem::path liveLog = output / "leaderboard.txt";
+    bool outputIsInput = false, logIsInput = false;
+    for (int i = 2; i < argc; i++)
+    {
+        outputIsInput = outputIsInput || filesystem::equivalent(argv[i], output, ec);
+        logIsInput = logIsInput || filesystem::equivalent(argv[i], liveLog, ec);
+    }
+    vector<filesystem::path> outputLogs;
+    for (const auto &file : filesystem::directory_iterator(output, ec))
+    {
+        string name = file.path().filename().string();
+        if ((name == "leaderboard.txt" && file.file_size(ec) > 0) || isRotatedLog(name))
+            outputLogs.push_back(file.path());
+    }
+    for (const auto &log : outputLogs)
+    {
+        if (outputIsInput || (logIsInput && log == liveLog))
+            continue;
+        cerr << "Error: " << log.string() << " holds games that are not among the inputs; "
+             << "pass " << output.string() << " as an input to include them\n";
+        return 1;
+    }
+
+    vector<Run> runs;
+    size_t total = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        filesystem::path input = argv[i];
+        if (filesystem::is_directory(input, ec))
+        {
+            if (!addKiosk(input, runs, total))
+            {
+                cerr << "Error: Unable to read kiosk directory " << input.string() << "\n";
+                return 1;
+            }
+        }
+        else if (input.extension() == ".lbs")
+            runs.push_back(segmentRun(input.string(), total));
+        else
+            runs.push_back(textRun(input.string(), total));
+    }
+    if (any_of(runs.begin(), runs.end(), [](const Run &run)
+               { return !run; }))
+        return 1;
+
+    // k-way heap merge; equal games come out in input order
+    struct Head
+    {
+        LeaderboardEntry entry;
+        size_t run;
+    };
+    auto after = [](const Head &a, const Head &b)
+    {
+        if (b.entry < a.entry)
+            return true;
+        return !(a.entry < b.entry) && a.run > b.run;
+    };
+    priority_queue<Head, vector<Head>, decltype(after)> heap(after);
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        Head head{{}, i};
+        if (runs[i](head.entry))
+            heap.push(move(head));
+    }
+
+    // Identity -> spelling of that player's best game
+    unordered_map<string, string> players;
+    // Games equal to the last one written, to drop the same game seen twice
+    // (a kiosk file passed twice, or a log copied between kiosks)
+    vector<LeaderboardEntry> tied;
+    size_t read = 0, duplicates = 0;
+
+    auto start = chrono::steady_clock::now();
+    filesystem::create_directories(archive, ec);
+    string segmentPath = (archive / "1-1.lbs").string();
+
+    // Sized like the game's own merges would have left it, so new flushes
+    // merge among themselves before touching it
+    uint32_t level = 0;
+    for (size_t capacity = Leaderboard::MEMTABLE_LIMIT; capacity < total; capacity *= Leaderboard::MERGE_FANIN)
+        level++;
+
+    auto nextGame = [&](LeaderboardEntry &entry)
+    {
+        while (!heap.empty())
+        {
+            Head head = heap.top();
+            heap.pop();
+            read++;
+            Head next{{}, head.run};
+            if (runs[head.run](next.entry))
+                heap.push(move(next));
+
+            auto player = players.emplace(identityOf(head.entry.playerName), head.entry.playerName).first;
+            head.entry.playerName = player->second;
+
+            if (!tied.empty() && (tied.front() < head.entry || head.entry < tied.front()))
+                tied.clear();
+            auto sameGame = [&](const LeaderboardEntry &other)
+            {
+                return other.playerName == head.entry.playerName &&
+                       other.gamesPlayed == head.entry.gamesPlayed &&
+                       other.timestamp == head.entry.timestamp;
+            };
+            if (head.entry.timestamp != 0 && any_of(tied.begin(), tied.end(), sameGame))
+            {
+                duplicates++;
+                continue;
+            }
+            tied.push_back(head.entry);
+            entry = move(head.entry);
+            return true;
+        }
+        return false;
+    };
+    bool written = LeaderboardSegment::write(segmentPath, level, 1, 1, nextGame);
+    if (!written)
+        return 1;
+
+    // The game expects a live log beside the archive; the merged one starts
+    // empty. Rotated logs already merged would otherwise be replayed on load.
+    ofstream log(liveLog.string(), ios::trunc);
+    log.close();
+    for (const auto &rotated : outputLogs)
+    {
+        if (rotated != liveLog)
+            filesystem::remove(rotated, ec);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Merged " << read << " games from " << runs.size() << " inputs into " << segmentPath << "\n"
+         << players.size() << " players, " << duplicates << " duplicate games dropped\n"
+         << (seconds > 0 ? read / seconds / 1e6 : 0.0) << " million games/s\n";
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include "question_bank.hpp"
+
+using namespace std;
+
+// Offline compiler: docs/questions.txt -> docs/questions.qpack
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        cerr << "Usage: wwtbam-packc <questions.txt> [output.qpack]\n";
+        return 1;
+    }
+
+    string input = argv[1];
+    string output;
+    if (argc == 3)
+    {
+        output = argv[2];
+    }
+    else
+    {
+        size_t dot = input.find_last_of('.');
+        size_t slash = input.find_last_of("/\\");
+        if (dot == string::npos || (slash != string::npos && dot < slash))
+            dot = input.size();
+        output = input.substr(0, dot) + ".qpack";
+    }
+
+    QuestionBank bank;
+    if (!bank.loadFromFile(input, LoadMode::PARALLEL))
+        return 1;
+
+    if (!bank.saveToPack(output))
+        return 1;
+
+    cout << "Compiled " << bank.getTotalQuestions() << " questions into " << output << "\n";
+    return 0;
+}
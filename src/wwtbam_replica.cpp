@@ -0,0 +1,59 @@
+#include <iostream>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include "leaderboard.hpp"
+#include "leaderboard_replicator.hpp"
+
+using namespace std;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+// Headless leaderboard replica, run beside a docs directory like the game: a
+// kiosk without a screen, or several on one machine to try replication.
+// Leaderboard lines on stdin are added as games finished here; after stdin
+// closes it keeps syncing until interrupted.
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: wwtbam-replica <port> [peer host:port]... < games\n";
+        return 1;
+    }
+
+    Leaderboard leaderboard;
+    LeaderboardReplicator replicator(leaderboard);
+    vector<string> peers(argv + 2, argv + argc);
+    if (!replicator.start((int)strtol(argv[1], nullptr, 10), peers))
+        return 1;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    string line;
+    while (!interrupted && getline(cin, line))
+    {
+        LeaderboardEntry entry;
+        if (!Leaderboard::parseEntry(line, entry))
+        {
+            cerr << "Skipping malformed game: " << line << "\n";
+            continue;
+        }
+        replicator.publish({entry});
+        leaderboard.addEntry(entry);
+        leaderboard.saveToFile();
+    }
+    while (!interrupted)
+        this_thread::sleep_for(chrono::milliseconds(100));
+
+    replicator.stop();
+    cout << "Instance " << replicator.getInstanceId() << ": " << leaderboard.getTotalGames() << " games\n";
+    for (const auto &version : replicator.getVersions())
+        cout << "  " << version.first << " " << version.second << "\n";
+    return 0;
+}
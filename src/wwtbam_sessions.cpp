@@ -0,0 +1,344 @@
+#include <iostream>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <cstdlib>
+#include "session_manager.hpp"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+static const int SHUT_BOTH = SD_BOTH;
+#define poll WSAPoll
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+using SocketHandle = int;
+static const SocketHandle NO_SOCKET = -1;
+static const int SHUT_BOTH = SHUT_RDWR;
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+// Classroom and event host: one process runs a game per connected player
+// through SessionManager, headless, beside a docs directory like the game.
+// Clients (a web bridge, a class's own front end, or telnet) connect over
+// TCP and send one request per line, fields separated by '|'; every request
+// gets one reply line. Meant for a trusted LAN like replication: any client
+// may act on any session id.
+//   START|<name>|<gender>[|<mode>]  OK|<id>
+//   QUESTION|<id>                   QUESTION|<category>|<seconds left>|<text>|<A>|<B>|<C>|<D>, or OVER
+//   ANSWER|<id>|<slot 0-3>          CORRECT, WRONG, TIMED_OUT, WON or NO_QUESTION
+//   FIFTY|<id>                      REMOVED|<slot>|<slot>
+//   FRIEND|<id>                     FRIEND|<slot>
+//   SKIP|<id>                       OK
+//   HINT|<id>                       HINT|<text>
+//   STATUS|<id>                     STATUS|<name>|<level>|<winnings>|<points>|<streak>|<answered>|<seconds left>|<active>|<rank>
+//   END|<id>                        OK
+// Anything else, or a request the game does not allow now, gets ERR|<reason>.
+
+static const size_t MAX_LINE = 4096;
+static const size_t MAX_NAME = 16; // as on the kiosk's name entry
+static const int IDLE_SECONDS = 600; // sessions whose client went quiet are ended
+static const int SWEEP_SECONDS = 30;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+static void closeSocket(SocketHandle socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static SocketHandle listenOn(int port)
+{
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == NO_SOCKET)
+        return NO_SOCKET;
+
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+    {
+        closeSocket(listener);
+        return NO_SOCKET;
+    }
+    return listener;
+}
+
+static bool sendAll(SocketHandle socket, const string &data)
+{
+    for (size_t sent = 0; sent < data.size();)
+    {
+        int n = (int)send(socket, data.data() + sent, (int)(data.size() - sent), MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+static vector<string> splitFields(const string &line, char separator)
+{
+    vector<string> fields;
+    stringstream ss(line);
+    string field;
+    while (getline(ss, field, separator))
+        fields.push_back(field);
+    return fields;
+}
+
+static const char *outcomeName(AnswerOutcome outcome)
+{
+    switch (outcome)
+    {
+    case AnswerOutcome::CORRECT:
+        return "CORRECT";
+    case AnswerOutcome::WRONG:
+        return "WRONG";
+    case AnswerOutcome::TIMED_OUT:
+        return "TIMED_OUT";
+    case AnswerOutcome::WON:
+        return "WON";
+    default:
+        return "NO_QUESTION";
+    }
+}
+
+static string handleRequest(SessionManager &manager, const string &line)
+{
+    vector<string> fields = splitFields(line, '|');
+    if (fields.empty())
+        return "ERR|empty request";
+    const string &command = fields[0];
+
+    if (command == "START")
+    {
+        if (fields.size() < 3 || fields.size() > 4 || fields[1].empty() || fields[1].size() > MAX_NAME ||
+            fields[2].size() > MAX_NAME)
+            return "ERR|expected START|<name>|<gender>[|<mode>], names up to " + to_string(MAX_NAME) + " characters";
+        uint64_t id = manager.startSession(fields[1], fields[2], fields.size() == 4 ? fields[3] : "classic");
+        return id ? "OK|" + to_string(id) : "ERR|no question bank loaded";
+    }
+
+    if (fields.size() < 2 || fields[1].find_first_not_of("0123456789") != string::npos || fields[1].empty())
+        return "ERR|expected " + command + "|<id>";
+    uint64_t id = strtoull(fields[1].c_str(), nullptr, 10);
+
+    if (command == "QUESTION")
+    {
+        Question question;
+        SessionStatus status;
+        if (!manager.nextQuestion(id, question))
+            return manager.getStatus(id, status) ? "OVER" : "ERR|unknown session";
+        manager.getStatus(id, status);
+        string reply = "QUESTION|" + to_string(question.category) + "|" + to_string(status.remainingSeconds) + "|" +
+                       question.text;
+        for (int slot = 0; slot < 4; slot++)
+            reply += string("|") + question.displayedOption(slot);
+        return reply;
+    }
+    if (command == "ANSWER")
+    {
+        if (fields.size() != 3 || fields[2].size() != 1 || fields[2][0] < '0' || fields[2][0] > '3')
+            return "ERR|expected ANSWER|<id>|<slot 0-3>";
+        return outcomeName(manager.answer(id, fields[2][0] - '0'));
+    }
+    if (command == "FIFTY")
+    {
+        vector<int> removed = manager.use50_50Lifeline(id);
+        if (removed.size() != 2)
+            return "ERR|50:50 not available";
+        return "REMOVED|" + to_string(removed[0]) + "|" + to_string(removed[1]);
+    }
+    if (command == "FRIEND")
+    {
+        int suggestion = manager.useAskFriendLifeline(id);
+        return suggestion < 0 ? "ERR|ask a friend not available" : "FRIEND|" + to_string(suggestion);
+    }
+    if (command == "SKIP")
+        return manager.useSkipLifeline(id) ? "OK" : "ERR|skip not available";
+    if (command == "HINT")
+    {
+        string hint = manager.useHintLifeline(id);
+        return hint.empty() ? "ERR|hint not available" : "HINT|" + hint;
+    }
+    if (command == "STATUS")
+    {
+        SessionStatus status;
+        if (!manager.getStatus(id, status))
+            return "ERR|unknown session";
+        return "STATUS|" + status.playerName + "|" + to_string(status.level) + "|" + to_string(status.winnings) + "|" +
+               to_string(status.points) + "|" + to_string(status.streak) + "|" + to_string(status.questionsAnswered) +
+               "|" + to_string(status.remainingSeconds) + "|" + (status.active ? "1" : "0") + "|" +
+               to_string(status.finalRank);
+    }
+    if (command == "END")
+        return manager.endSession(id) ? "OK" : "ERR|unknown session";
+    return "ERR|unknown request " + command;
+}
+
+// One thread per connection; the manager takes requests from any thread
+struct Client
+{
+    SocketHandle socket;
+    thread worker;
+    atomic<bool> done{false};
+};
+
+static void serve(SessionManager &manager, Client &client)
+{
+    string inbox;
+    char buffer[4096];
+    for (;;)
+    {
+        int n = (int)recv(client.socket, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            break;
+        inbox.append(buffer, (size_t)n);
+
+        size_t start = 0, end;
+        bool ok = true;
+        while (ok && (end = inbox.find('\n', start)) != string::npos)
+        {
+            string line = inbox.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            start = end + 1;
+            if (!line.empty())
+                ok = sendAll(client.socket, handleRequest(manager, line) + "\n");
+        }
+        inbox.erase(0, start);
+        if (!ok || inbox.size() > MAX_LINE)
+            break;
+    }
+    client.done = true; // closed by main once joined
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: wwtbam-sessions <port> [--paged <MB>] [--replicate <port> [--peer <host:port>]...]\n";
+        return 1;
+    }
+    int port = (int)strtol(argv[1], nullptr, 10);
+    size_t pageCacheBytes = 0;
+    int replicationPort = 0;
+    vector<string> peers;
+    for (int i = 2; i + 1 < argc; i++)
+    {
+        if (string(argv[i]) == "--paged")
+            pageCacheBytes = (size_t)max(1L, strtol(argv[i + 1], nullptr, 10)) << 20;
+        else if (string(argv[i]) == "--replicate")
+            replicationPort = (int)strtol(argv[i + 1], nullptr, 10);
+        else if (string(argv[i]) == "--peer")
+            peers.push_back(argv[i + 1]);
+    }
+
+    SessionManager manager;
+    if (!manager.initialize("docs/questions.txt", pageCacheBytes))
+    {
+        cerr << "Failed to load questions. Make sure 'docs/questions.txt' exists.\n";
+        return 1;
+    }
+    if (replicationPort > 0 && !manager.startReplication(replicationPort, peers))
+        cerr << "Leaderboard replication is off; playing with this host's board only.\n";
+
+#ifdef _WIN32
+    WSADATA winsock;
+    if (WSAStartup(MAKEWORD(2, 2), &winsock) != 0)
+        return 1;
+#endif
+    SocketHandle listener = listenOn(port);
+    if (listener == NO_SOCKET)
+    {
+        cerr << "Error: Unable to listen on port " << port << "\n";
+        return 1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    cout << "Hosting games on port " << port << "\n";
+
+    list<unique_ptr<Client>> clients;
+    auto lastSweep = chrono::steady_clock::now();
+    while (!interrupted)
+    {
+        pollfd ready = {};
+        ready.fd = listener;
+        ready.events = POLLIN;
+        if (poll(&ready, 1, 1000) > 0 && (ready.revents & POLLIN))
+        {
+            SocketHandle socket = accept(listener, nullptr, nullptr);
+            if (socket != NO_SOCKET)
+            {
+#ifdef SO_NOSIGPIPE
+                int on = 1;
+                setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+                clients.push_back(make_unique<Client>());
+                Client &client = *clients.back();
+                client.socket = socket;
+                client.worker = thread(serve, ref(manager), ref(client));
+            }
+        }
+
+        for (auto it = clients.begin(); it != clients.end();)
+        {
+            if ((*it)->done)
+            {
+                (*it)->worker.join();
+                closeSocket((*it)->socket);
+                it = clients.erase(it);
+            }
+            else
+                ++it;
+        }
+        if (chrono::steady_clock::now() - lastSweep >= chrono::seconds(SWEEP_SECONDS))
+        {
+            size_t closed = manager.closeIdleSessions(IDLE_SECONDS);
+            if (closed > 0)
+                cout << "Ended " << closed << " idle sessions\n";
+            lastSweep = chrono::steady_clock::now();
+        }
+    }
+
+    // Wakes each client thread out of recv; their sessions end with the manager
+    closeSocket(listener);
+    for (auto &client : clients)
+    {
+        shutdown(client->socket, SHUT_BOTH);
+        client->worker.join();
+        closeSocket(client->socket);
+    }
+    manager.shutdown();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    cout << "Leaderboard holds " << manager.getLeaderboard().getTotalGames() << " games\n";
+    return 0;
+}